@@ -0,0 +1,295 @@
+#include "Batch.h"
+
+#include "Boolean.h"
+#include "Cost.h"
+#include "Expression.h"
+#include "Float.h"
+#include "Integer.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//	column of the table that feeds a variable slot of the statement
+	struct Column
+	{
+		std::size_t index;
+		std::size_t slot;
+	};
+
+	struct Chunk
+	{
+		std::string results;
+		std::size_t rows = 0;
+		bool done = false;
+	};
+
+	std::string_view trim(std::string_view field)
+	{
+		const auto isBlank = [] (char ch) { return ch == ' ' || ch == '\t' || ch == '\r'; };
+
+		while (!field.empty() && isBlank(field.front()))
+			field.remove_prefix(1);
+		while (!field.empty() && isBlank(field.back()))
+			field.remove_suffix(1);
+
+		return field;
+	}
+
+	//	parses a field where it lies in the table, without copying it out first
+	token::operand::Ptr scanValue(std::string_view field)
+	{
+		field = trim(field);
+
+		if (field == "True")
+			return std::make_shared<token::operand::Boolean>(true);
+		if (field == "False")
+			return std::make_shared<token::operand::Boolean>(false);
+
+		auto first = field.data();
+		const auto last = first + field.size();
+
+		if (first != last && *first == '+')
+			++first;
+
+		if (first != last) {
+			if (field.find_first_of(".eE") == std::string_view::npos) {
+				auto value = 0ll;
+				if (const auto [end, error] = std::from_chars(first, last, value); error == std::errc() && end == last)
+					return std::make_shared<token::operand::Integer>(value);
+			}
+			else {
+				auto value = 0.0;
+				if (const auto [end, error] = std::from_chars(first, last, value); error == std::errc() && end == last)
+					return std::make_shared<token::operand::Float>(value);
+			}
+		}
+
+		throw std::runtime_error("Invalid value '" + std::string(field) + "'");
+	}
+
+	//	mean length of the first rows of the table, newlines included
+	double rowBytes(std::string_view rows)
+	{
+		auto count = std::size_t(0), length = std::size_t(0);
+
+		for (; count < 64 && length < rows.size(); ++count) {
+			const auto lineEnd = rows.find('\n', length);
+			length = lineEnd == std::string_view::npos ? rows.size() : lineEnd + 1;
+		}
+
+		return count ? static_cast<double>(length) / count : 1.0;
+	}
+
+	std::vector<Column> bindColumns(std::string_view header, char delimiter, const compiled::Expression& statement, const compiled::Bindings& defaults)
+	{
+		std::vector<std::string_view> names;
+
+		for (auto separator = header.find(delimiter); ; separator = header.find(delimiter)) {
+			names.push_back(trim(header.substr(0, separator)));
+
+			if (separator == std::string_view::npos)
+				break;
+			header.remove_prefix(separator + 1);
+		}
+
+		std::vector<Column> columns;
+
+		for (auto slot = 0u; slot < statement.getAliases().size(); ++slot)
+		{
+			const auto& alias = statement.getAliases()[slot];
+
+			if (const auto found = std::find(std::begin(names), std::end(names), alias); found != std::end(names))
+				columns.push_back({static_cast<std::size_t>(std::distance(std::begin(names), found)), slot});
+			else if (!defaults[slot])
+				throw std::runtime_error("No column or value for variable '" + alias + "'");
+		}
+
+		std::sort(std::begin(columns), std::end(columns), [] (const Column& lhs, const Column& rhs) { return lhs.index < rhs.index; });
+		return columns;
+	}
+
+	//	evaluates every line of 'rows', appending one result per line; returns the number of rows evaluated
+	std::size_t evaluateRows(std::string_view rows, char delimiter, const std::vector<Column>& columns,
+							 const compiled::Expression& statement, compiled::Bindings& bindings, std::string& results)
+	{
+		auto count = std::size_t(0);
+
+		while (!rows.empty())
+		{
+			const auto lineEnd = rows.find('\n');
+			auto line = rows.substr(0, lineEnd);
+			rows.remove_prefix(lineEnd == std::string_view::npos ? rows.size() : lineEnd + 1);
+
+			if (trim(line).empty())
+				continue;
+
+			const auto row = line;
+			auto column = std::begin(columns);
+
+			for (auto field = 0u; column != std::end(columns); ++field) {
+				const auto separator = line.find(delimiter);
+
+				if (field == column->index) {
+					bindings[column->slot] = scanValue(line.substr(0, separator));
+					++column;
+				}
+
+				if (separator == std::string_view::npos)
+					break;
+				line.remove_prefix(separator + 1);
+			}
+
+			if (column != std::end(columns))
+				throw std::runtime_error("Missing column in row '" + std::string(trim(row)) + "'");
+
+			results += statement.evaluate(bindings)->toString();
+			results += '\n';
+			++count;
+		}
+
+		return count;
+	}
+}
+
+batch::Options::Options()
+	:
+	delimiter(0),
+	threads(std::max(1u, std::thread::hardware_concurrency())),
+	chunkSize(1 << 20),
+	chunkCost(1e7),
+	chunksInFlight(4 * threads),
+	maxCost(0)
+{ }
+
+std::size_t batch::evaluate(std::string_view formula, std::string_view table, std::ostream& output, const Options& options)
+{
+	const auto headerEnd = table.find('\n');
+	const auto header = table.substr(0, headerEnd);
+	auto body = headerEnd == std::string_view::npos ? std::string_view() : table.substr(headerEnd + 1);
+
+	auto delimiter = options.delimiter;
+	if (!delimiter) {
+		const auto found = header.find_first_of(",\t");
+		delimiter = found == std::string_view::npos ? ',' : header[found];
+	}
+
+	const auto statement = compiled::Expression::compile(formula);
+	const auto cost = compiled::estimateCost(statement);
+
+	if (options.maxCost > 0 && cost > options.maxCost)
+		throw std::runtime_error("Estimated cost of " + std::to_string(std::llround(cost)) + " ns per row exceeds the limit of " + std::to_string(std::llround(options.maxCost)));
+
+	const auto columns = bindColumns(header, delimiter, statement, statement.bind(compiled::parseVariables(formula)));
+
+	std::mutex mutex;
+	std::condition_variable chunkDone, chunkWritten;
+	std::deque<Chunk> pending;
+	std::exception_ptr failure;
+
+	auto chunkSize = std::max<std::size_t>(options.chunkSize, 1);
+	if (options.chunkCost > 0)
+		chunkSize = std::clamp<std::size_t>(static_cast<std::size_t>(options.chunkCost / cost * rowBytes(body)), 1, chunkSize);
+
+	const auto chunksInFlight = std::max<std::size_t>(options.chunksInFlight, 1);
+
+	const auto worker = [&] {
+		//	every worker compiles its own copy, so no operand is shared between threads
+		const auto local = compiled::Expression::compile(formula);
+		auto bindings = local.bind(compiled::parseVariables(formula));
+
+		for (;;)
+		{
+			std::string_view rows;
+			Chunk* chunk = nullptr;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				chunkWritten.wait(lock, [&] { return failure || body.empty() || pending.size() < chunksInFlight; });
+
+				if (failure || body.empty())
+					return;
+
+				const auto lineEnd = body.find('\n', std::min(chunkSize, body.size()) - 1);
+				rows = body.substr(0, lineEnd == std::string_view::npos ? body.size() : lineEnd + 1);
+				body.remove_prefix(rows.size());
+
+				chunk = &pending.emplace_back();
+			}
+
+			std::string results;
+			auto count = std::size_t(0);
+
+			try {
+				count = evaluateRows(rows, delimiter, columns, local, bindings, results);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!failure) failure = std::current_exception();
+
+				chunkDone.notify_all();
+				chunkWritten.notify_all();
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				chunk->results = std::move(results);
+				chunk->rows = count;
+				chunk->done = true;
+			}
+
+			chunkDone.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (auto i = 0u; i < std::max(options.threads, 1u); ++i)
+		workers.emplace_back(worker);
+
+	output << "result\n";
+
+	auto rowsWritten = std::size_t(0);
+
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		chunkDone.wait(lock, [&] { return failure || (pending.empty() && body.empty()) || (!pending.empty() && pending.front().done); });
+
+		if (failure || pending.empty())
+			break;
+
+		const auto chunk = std::move(pending.front());
+		pending.pop_front();
+		lock.unlock();
+
+		chunkWritten.notify_all();
+
+		output << chunk.results;
+		rowsWritten += chunk.rows;
+	}
+
+	for (auto& thread : workers)
+		thread.join();
+
+	if (failure)
+		std::rethrow_exception(failure);
+
+	return rowsWritten;
+}
+
+std::size_t batch::evaluateFile(std::string_view formula, const std::string& path, std::ostream& output, const Options& options)
+{
+	const utils::MappedFile file(path);
+	return evaluate(formula, file.getData(), output, options);
+}
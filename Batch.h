@@ -0,0 +1,36 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace batch
+{
+	struct Options
+	{
+		Options();
+
+		char delimiter;				//	0 picks ',' or '\t', whichever appears first in the header
+		unsigned threads;
+		std::size_t chunkSize;		//	bytes of input handed to a worker at once, at most
+		double chunkCost;			//	estimated nanoseconds of work handed to a worker at once, 0 to split by chunkSize alone
+		std::size_t chunksInFlight;	//	bound on the chunks evaluated but not yet written
+		double maxCost;				//	estimated nanoseconds per row above which the formula is rejected unread, 0 for no limit
+	};
+
+	//	evaluates the statement of 'formula' once for every row of 'table'
+	//	the first line of the table names the columns, which are bound to the variables with the same alias
+	//	variables of the formula's preamble act as defaults for the aliases without a column
+	//	results are written to 'output' as a single column named "result", in row order
+	//	the rows are split into chunks of about the same estimated cost (see compiled::estimateCost), so an expensive
+	//	formula is spread over more, smaller chunks and the threads finish together
+	//	returns the number of rows evaluated
+	std::size_t evaluate(std::string_view formula, std::string_view table, std::ostream& output, const Options& options = {});
+
+	//	same as above, reading the table from a memory-mapped file
+	std::size_t evaluateFile(std::string_view formula, const std::string& path, std::ostream& output, const Options& options = {});
+}
+
+#endif
@@ -0,0 +1,766 @@
+#include "Benchmark.h"
+
+#include "CInterface.h"
+#include "Catalogue.h"
+#include "Cost.h"
+#include "Currency.h"
+#include "Expression.h"
+#include "Filter.h"
+#include "Float.h"
+#include "Gradient.h"
+#include "Integer.h"
+#include "Operator.h"
+#include "Registry.h"
+#include "Session.h"
+#include "SyntaxTree.h"
+#include "Tiering.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	//	written by every measured call so that the optimizer can't drop the work
+	volatile std::size_t sink;
+
+	//	calls 'function' in growing rounds until a round takes long enough, and returns the mean time per call in nanoseconds
+	template <typename Function>
+	double measure(Function&& function)
+	{
+		for (auto iterations = std::size_t(1); ; iterations *= 2)
+		{
+			const auto start = Clock::now();
+			for (auto i = std::size_t(0); i < iterations; ++i)
+				function();
+			const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+			if (elapsed > 2e8 || iterations >= (std::size_t(1) << 30))
+				return elapsed / iterations;
+		}
+	}
+
+	void report(std::ostream& output, std::string_view name, double baseline, double optimized)
+	{
+		output << name << ": " << baseline << " ns -> " << optimized << " ns (" << baseline / optimized << "x)\n";
+	}
+
+	//	the scanning helpers as they were before the character class table
+	std::string_view skipWhitespaceLocale(std::string_view str)
+	{
+		const auto found = std::find_if(str.begin(), str.end(), [] (char ch) { return !std::isspace<char>(ch, std::locale::classic()); });
+		return str.substr(std::distance(str.begin(), found));
+	}
+
+	std::size_t aliasLengthFindFirstNotOf(std::string_view str)
+	{
+		static const auto delimiters = "abcdefghijklmnopqrstuvwxyz0123456789_";
+		return std::min(str.find_first_not_of(delimiters, 1), str.size());
+	}
+
+	std::size_t digitsFindIf(std::string_view str)
+	{
+		return std::distance(str.begin(), std::find_if(str.begin(), str.end(), [] (char ch) { return !std::isdigit<char>(ch, std::locale::classic()); }));
+	}
+
+	void scanning(std::ostream& output)
+	{
+		for (const auto length : {1, 4, 16, 64, 256})
+		{
+			const auto padding = std::string(length, ' ') + "\t\r\n" + std::string(length, ' ') + "x";
+			const auto identifier = "x" + std::string(length, 'a') + "_" + std::string(length, '9') + "*";
+			const auto digits = std::string(length, '7') + ".5";
+			const auto suffix = " (" + std::to_string(length) + ")";
+
+			report(output, "skip whitespace" + suffix,
+				   measure([&padding] { sink = skipWhitespaceLocale(padding).size(); }),
+				   measure([&padding] { sink = utils::str::skipWhitespace(padding).size(); }));
+
+			report(output, "identifier run" + suffix,
+				   measure([&identifier] { sink = aliasLengthFindFirstNotOf(identifier); }),
+				   measure([&identifier] { sink = 1 + utils::str::countIdentifier(std::string_view(identifier).substr(1)); }));
+
+			report(output, "digit run" + suffix,
+				   measure([&digits] { sink = digitsFindIf(digits); }),
+				   measure([&digits] { sink = utils::str::countDigits(digits); }));
+		}
+
+		std::string formula = "longvariablename_0123456789 = 2;";
+		for (auto term = 0; term < 64; ++term)
+			formula += std::string(32, ' ') + "longvariablename_0123456789 *\t\t\t\t 1234567.25 +";
+		formula += " 1";
+
+		output << "compile padded formula (" << formula.size() << " bytes): "
+			   << measure([&formula] { sink = compiled::Expression::compile(formula).getInstructions().size(); }) << " ns\n";
+	}
+
+	//	formulas built from a few hundred normalizations and logarithms, as in a feature catalogue
+	void catalogue(std::ostream& output)
+	{
+		const auto feature = [] (int i) { return "(x" + std::to_string(i) + " - m" + std::to_string(i) + ") / s" + std::to_string(i); };
+		const auto logarithm = [] (int i) { return "Log10(y" + std::to_string(i) + " + 1)"; };
+
+		std::string preamble;
+		for (auto i = 0; i < 100; ++i)
+			preamble += "x" + std::to_string(i) + " = " + std::to_string(i * 3 + 1) + " m" + std::to_string(i) + " = 1.5 s" + std::to_string(i)
+					  + " = 2.25 y" + std::to_string(i) + " = " + std::to_string(i * 10) + " ";
+		preamble += ";";
+
+		compiled::Catalogue shared;
+		std::vector<compiled::Expression> independent;
+
+		for (auto i = 0; i < 20000; ++i)
+		{
+			const auto formula = feature(i % 100) + " * " + feature((i * 7 + 3) % 100) + " + " + logarithm(i % 37) + " * " + std::to_string(i % 10);
+			shared.add("f" + std::to_string(i), formula);
+			independent.push_back(compiled::Expression::compile(formula));
+		}
+
+		const auto vars = compiled::parseVariables(preamble);
+		const auto statistics = shared.getStatistics();
+
+		output << statistics.formulas << " formulas: " << statistics.instructions << " instructions -> " << statistics.nodes << " nodes, "
+			   << statistics.independentBytes << " bytes -> " << statistics.sharedBytes << " bytes ("
+			   << static_cast<double>(statistics.independentBytes) / statistics.sharedBytes << "x)\n";
+
+		std::vector<compiled::Bindings> bindings;
+		for (const auto& expression : independent)
+			bindings.push_back(expression.bind(vars));
+		const auto sharedBindings = shared.bind(vars);
+
+		report(output, "evaluate catalogue",
+			   measure([&independent, &bindings] {
+				   for (auto i = std::size_t(0); i < independent.size(); ++i)
+					   sink = independent[i].evaluate(bindings[i]) != nullptr;
+			   }),
+			   measure([&shared, &sharedBindings] { sink = shared.evaluate(sharedBindings).size(); }));
+	}
+
+	//	the gradient of a formula over 16 variables, by forward differences (one evaluation per variable) and by the adjoint sweep
+	void gradient(std::ostream& output)
+	{
+		std::string formula = "0";
+		std::string preamble;
+
+		for (auto i = 0; i < 16; ++i) {
+			const auto x = "x" + std::to_string(i);
+			formula += " + Sin(" + x + ") * " + x + " ^ 2 / (1 + Exp(-" + x + "))";
+			preamble += x + " = " + std::to_string(0.25 * (i + 1)) + " ";
+		}
+
+		const auto expression = compiled::Expression::compile(formula);
+		const auto bindings = expression.bind(compiled::parseVariables(preamble + ";"));
+
+		report(output, "gradient (16 variables)",
+			   measure([&expression, &bindings] {
+				   const auto base = std::get<double>(expression.evaluate(bindings)->getValue());
+				   auto shifted = bindings;
+				   auto sum = 0.0;
+
+				   for (auto slot = std::size_t(0); slot < bindings.size(); ++slot) {
+					   const auto x = std::get<double>(bindings[slot]->getValue());
+					   shifted[slot] = std::make_shared<token::operand::Float>(x + 1e-7);
+					   sum += (std::get<double>(expression.evaluate(shifted)->getValue()) - base) / 1e-7;
+					   shifted[slot] = bindings[slot];
+				   }
+
+				   sink = sum != 0;
+			   }),
+			   measure([&expression, &bindings] { sink = compiled::gradient(expression, bindings).partials.size(); }));
+	}
+
+	//	the operations emitted for a constant exponent or divisor, against the ones they replace
+	void strength(std::ostream& output)
+	{
+		const token::operand::Ptr integer = std::make_shared<token::operand::Integer>(1234);
+		const token::operand::Ptr real = std::make_shared<token::operand::Float>(1.2345);
+
+		const auto operation = [] (token::Operator::Type type, token::operand::Ptr left, token::operand::Ptr right) {
+			return [type, left, right] { sink = token::Operator {type, 2, 2}.compute(left, right) != nullptr; };
+		};
+
+		for (const auto exponent : {2, 3, 5})
+		{
+			const token::operand::Ptr constant = std::make_shared<token::operand::Integer>(exponent);
+			const auto suffix = " ^ " + std::to_string(exponent);
+
+			report(output, "integer" + suffix,
+				   measure(operation(token::Operator::Power, integer, constant)), measure(operation(token::Operator::IntegerPower, integer, constant)));
+			report(output, "float" + suffix,
+				   measure(operation(token::Operator::Power, real, constant)), measure(operation(token::Operator::IntegerPower, real, constant)));
+		}
+
+		report(output, "float / 4",
+			   measure(operation(token::Operator::FloatDivision, real, std::make_shared<token::operand::Integer>(4))),
+			   measure(operation(token::Operator::Multiplication, real, std::make_shared<token::operand::Float>(0.25))));
+	}
+
+	//	every operation measured on Float operands, unfused as compileBaseline leaves it next to its weight in
+	//	compiled::operationCost, which should be updated from here, and fused as compile runs it next to its estimate;
+	//	then whole formulas next to their estimates
+	void cost(std::ostream& output)
+	{
+		const std::vector<std::pair<std::string_view, token::Operator::Type>> operations {
+			{"x ^ y", token::Operator::Power}, {"x ^ 3", token::Operator::IntegerPower}, {"+x", token::Operator::Positive},
+			{"-x", token::Operator::Negative}, {"x * y", token::Operator::Multiplication}, {"x / y", token::Operator::FloatDivision},
+			{"x \\ y", token::Operator::IntegerDivision}, {"x Mod y", token::Operator::Mod}, {"x + y", token::Operator::Sum},
+			{"x - y", token::Operator::Difference}, {"x << 2", token::Operator::LeftBitshift}, {"x >> 2", token::Operator::RightBitshift},
+			{"x = y", token::Operator::Equality}, {"x <> y", token::Operator::Inequality}, {"x < y", token::Operator::LessThan},
+			{"x <= y", token::Operator::LessThanEqual}, {"x > y", token::Operator::GreaterThan}, {"x >= y", token::Operator::GreaterThanEqual},
+			{"Not x", token::Operator::Not}, {"x And y", token::Operator::And}, {"x AndAlso y", token::Operator::AndAlso},
+			{"x Or y", token::Operator::Or}, {"x OrElse y", token::Operator::OrElse}, {"x Xor y", token::Operator::Xor},
+			{"Abs(x)", token::Operator::Abs}, {"Acos(y)", token::Operator::Acos}, {"Asin(y)", token::Operator::Asin},
+			{"Atan(x)", token::Operator::Atan}, {"Ceiling(x)", token::Operator::Ceil}, {"Cos(x)", token::Operator::Cos},
+			{"Exp(x)", token::Operator::Exp}, {"Floor(x)", token::Operator::Floor}, {"Log(x)", token::Operator::Log},
+			{"Log10(x)", token::Operator::Log10}, {"Round(x)", token::Operator::Round}, {"Sin(x)", token::Operator::Sin},
+			{"Sqrt(x)", token::Operator::Sqrt}, {"Tan(x)", token::Operator::Tan}, {"Truncate(x)", token::Operator::Truncate}
+		};
+
+		const auto timeOf = [] (const compiled::Expression& statement) {
+			compiled::Bindings bindings(statement.getAliases().size());
+			for (auto slot = std::size_t(0); slot < bindings.size(); ++slot)
+				bindings[slot] = std::make_shared<token::operand::Float>(statement.getAliases()[slot] == "x" ? 1.2345 : 0.75);
+
+			return measure([&statement, &bindings] { sink = statement.evaluate(bindings) != nullptr; });
+		};
+
+		//	the operands of every operation, pushed without it
+		const auto pushOne = timeOf(compiled::Expression::compileBaseline("x")), pushTwo = timeOf(compiled::Expression::compileBaseline("x y"));
+
+		for (const auto& [formula, type] : operations)
+		{
+			const auto unfused = compiled::Expression::compileBaseline(formula), fused = compiled::Expression::compile(formula);
+			const auto pushed = unfused.getInstructions().size() > 2 ? pushTwo : pushOne;
+
+			output << formula << ": " << timeOf(unfused) - pushed << " ns (weight " << compiled::operationCost(type) << "), fused "
+				   << timeOf(fused) << " ns (estimate " << compiled::estimateCost(fused) << ")\n";
+		}
+
+		for (const auto formula : {"x + y * 2", "(x - 3) / y + Sqrt(x * x + y * y)", "Exp(x) ^ Log(y) + Sin(x) * Cos(y) - Atan(x / y)"})
+			output << formula << ": " << timeOf(compiled::Expression::compile(formula)) << " ns (estimate " << compiled::estimateCost(compiled::Expression::compile(formula)) << ")\n";
+	}
+
+	//	a line total with prices as Floats and as Currency, whose exact arithmetic is the cost of results that don't drift
+	void currency(std::ostream& output)
+	{
+		const auto statement = compiled::Expression::compile("price * quantity - price * quantity * discount + shipping > limit");
+
+		const auto bindings = [&statement] (auto make) {
+			compiled::Bindings bound(statement.getAliases().size());
+			for (const auto& [name, value] : std::vector<std::pair<std::string, double>> {{"price", 19.99}, {"discount", 0.15}, {"shipping", 4.95}, {"limit", 100}})
+				bound[*statement.slotOf(name)] = make(value);
+
+			bound[*statement.slotOf("quantity")] = std::make_shared<token::operand::Integer>(7);
+			return bound;
+		};
+
+		const auto floats = bindings([] (double value) -> token::operand::Ptr { return std::make_shared<token::operand::Float>(value); });
+		const auto currencies = bindings([] (double value) -> token::operand::Ptr {
+			return std::make_shared<token::operand::Currency>(std::llround(value * token::operand::Currency::Scale));
+		});
+
+		report(output, "line total", measure([&] { sink = statement.evaluate(floats) != nullptr; }), measure([&] { sink = statement.evaluate(currencies) != nullptr; }));
+	}
+
+	//	one keystroke inside a long formula, evaluated from scratch and by an editing session
+	void editing(std::ostream& output)
+	{
+		for (const auto terms : {100, 1000})
+		{
+			std::string text = "x = 1.5 y = 2;";
+			for (auto term = 0; term < terms; ++term)
+				text += (term ? " + (" : " (") + std::string("(x * ") + std::to_string(term) + " + Sin(y * 3)) / (y + 1) - Sqrt(x + " + std::to_string(term) + "))";
+
+			incremental::Session session(text);
+			const auto offset = text.find("Sin(y * 3)", text.size() / 2) + 8;
+			auto digit = '3';
+
+			report(output, std::to_string(text.size()) + " bytes",
+				   measure([&text] {
+					   const auto statement = compiled::Expression::compile(text);
+					   sink = statement.evaluate(statement.bind(compiled::parseVariables(text))) != nullptr;
+				   }),
+				   measure([&session, &digit, offset] {
+					   digit = digit == '3' ? '4' : '3';
+					   sink = session.edit(offset, 1, std::string_view(&digit, 1)) != nullptr;
+				   }));
+		}
+	}
+
+	//	calls to functions defined in the preamble, against the same formula with every call expanded by hand
+	void functions(std::ostream& output)
+	{
+		const std::string preamble = "x = 1.5 y = 2 norm(a, b) = Sqrt(a * a + b * b), scaled(a, b) = norm(a * 2, b) / (1 + norm(a, b));";
+		std::string called, expanded;
+
+		for (auto term = 0; term < 50; ++term)
+		{
+			const auto a = "(x + " + std::to_string(term) + ")";
+			const auto norm = [] (const std::string& a, const std::string& b) { return "(Sqrt((" + a + ") * (" + a + ") + (" + b + ") * (" + b + ")))"; };
+
+			called += (term ? " + scaled(x + " : "scaled(x + ") + std::to_string(term) + ", y)";
+			expanded += (term ? " + (" : "(") + norm("(" + a + ") * 2", "y") + " / (1 + " + norm(a, "y") + "))";
+		}
+
+		const auto calledText = preamble + called, expandedText = "x = 1.5 y = 2;" + expanded;
+
+		report(output, "compile",
+			   measure([&expandedText] { sink = compiled::Expression::compile(expandedText).getInstructions().size(); }),
+			   measure([&calledText] { sink = compiled::Expression::compile(calledText).getInstructions().size(); }));
+
+		const auto expandedStatement = compiled::Expression::compile(expandedText), calledStatement = compiled::Expression::compile(calledText);
+		const auto expandedBindings = expandedStatement.bind(compiled::parseVariables(expandedText));
+		const auto calledBindings = calledStatement.bind(compiled::parseVariables(calledText));
+
+		report(output, "evaluate",
+			   measure([&expandedStatement, &expandedBindings] { sink = expandedStatement.evaluate(expandedBindings) != nullptr; }),
+			   measure([&calledStatement, &calledBindings] { sink = calledStatement.evaluate(calledBindings) != nullptr; }));
+	}
+
+	//	a predicate over columns, evaluated row by row into Boolean operands and as a filter producing a bitmask
+	void filter(std::ostream& output)
+	{
+		constexpr auto Rows = std::size_t(1) << 16;
+
+		std::vector<long long> x(Rows);
+		std::vector<double> y(Rows);
+		for (auto row = std::size_t(0); row < Rows; ++row) {
+			x[row] = static_cast<long long>(row * 7919 % 1000);
+			y[row] = static_cast<double>(row * 104729 % 1000) / 10;
+		}
+
+		for (const auto predicate : {"x > 900 AndAlso y < 50.5", "x < 500 And y >= 25 Or x = 7", "x > 900 AndAlso Sqrt(y) > 5"})
+		{
+			const auto statement = compiled::Expression::compile(predicate);
+			const auto xSlot = statement.slotOf("x").value(), ySlot = statement.slotOf("y").value();
+
+			std::vector<compiled::Column> columns(statement.getAliases().size());
+			columns[xSlot] = x;
+			columns[ySlot] = y;
+
+			const compiled::Filter filter(statement, {});
+			auto bindings = statement.bind({});
+
+			report(output, predicate,
+				   measure([&] {
+					   auto passed = std::size_t(0);
+					   for (auto row = std::size_t(0); row < Rows; ++row) {
+						   bindings[xSlot] = std::make_shared<token::operand::Integer>(x[row]);
+						   bindings[ySlot] = std::make_shared<token::operand::Float>(y[row]);
+						   passed += statement.evaluate(bindings)->toString() == "True";
+					   }
+					   sink = passed;
+				   }),
+				   measure([&filter, &columns] { sink = filter.mask(columns, Rows).size(); }));
+		}
+	}
+
+	//	a filter over every row, against one pruning the zones its predicate is decided on, as the data gets less ordered
+	void zones(std::ostream& output)
+	{
+		constexpr auto Rows = std::size_t(1) << 20;
+		constexpr auto ZoneRows = std::size_t(1024);
+
+		const auto statement = compiled::Expression::compile("Sqrt(x) > 990 AndAlso y < 50");
+		const compiled::Filter filter(statement, {});
+
+		for (const auto layout : {"sorted", "clustered", "shuffled"})
+		{
+			std::vector<long long> x(Rows);
+			std::vector<double> y(Rows);
+
+			//	clustered rows hold values from a small range per zone, in no order within it
+			for (auto row = std::size_t(0); row < Rows; ++row) {
+				const auto scattered = static_cast<long long>(row * 2654435761 % Rows);
+
+				x[row] = layout == std::string_view("sorted") ? static_cast<long long>(row)
+					   : layout == std::string_view("clustered") ? static_cast<long long>(row / ZoneRows * ZoneRows) + scattered % static_cast<long long>(ZoneRows)
+					   : scattered;
+				y[row] = static_cast<double>(scattered % 100);
+			}
+
+			std::vector<compiled::Column> columns(statement.getAliases().size());
+			columns[statement.slotOf("x").value()] = std::move(x);
+			columns[statement.slotOf("y").value()] = std::move(y);
+
+			const auto zoneMap = compiled::zoneMap(columns, Rows, ZoneRows);
+
+			report(output, layout,
+				   measure([&filter, &columns] { sink = filter.mask(columns, Rows).size(); }),
+				   measure([&filter, &columns, &zoneMap] { sink = filter.mask(columns, Rows, zoneMap).size(); }));
+		}
+	}
+
+	//	math functions of the same arguments in every evaluation, and with one of them new every time, without and with the memo
+	void memo(std::ostream& output)
+	{
+		const auto statement = compiled::Expression::compile("Sin(x) + Log10(y) * Exp(z) - Sqrt(x + y)");
+		const auto x = *statement.slotOf("x");
+
+		auto bindings = statement.bind(compiled::parseVariables("x = 0.5 y = 250 z = 1.25;"));
+		auto step = 0.0;
+
+		for (const auto repeated : {true, false})
+		{
+			const auto evaluate = [&] {
+				if (!repeated)
+					bindings[x] = std::make_shared<token::operand::Float>(step += 1e-9);
+				sink = statement.evaluate(bindings) != nullptr;
+			};
+
+			const auto unmemoized = measure(evaluate);
+
+			token::memo::enable(true);
+			token::memo::clear();
+			const auto memoized = measure(evaluate);
+			const auto [hits, misses] = token::memo::statistics();
+			token::memo::enable(false);
+			token::memo::clear();
+
+			report(output, std::string(repeated ? "same bindings" : "new x every time") + " (" + std::to_string(100 * hits / (hits + misses)) + "% hits)", unmemoized, memoized);
+		}
+	}
+
+	//	compiling with the operator stack loop against parsing a syntax tree and lowering it, on deeply nested and long statements
+	void parsing(std::ostream& output)
+	{
+		for (const auto size : {1000, 100000})
+		{
+			std::string nested, chained = "x";
+			for (auto term = 0; term < size; ++term) {
+				nested += term % 2 ? "(-" : "(Sqrt";
+				chained += (term % 3 ? " + y * " : " - 1.5 ^ ") + std::to_string(term);
+			}
+
+			nested += "x";
+			for (auto term = 0; term < size; ++term)
+				nested += " * 2)";
+
+			for (const auto& [name, text] : {std::pair<std::string, const std::string&> {"nested", nested}, {"chained", chained}})
+				report(output, name + " (" + std::to_string(text.size()) + " bytes)",
+					   measure([&text] { sink = compiled::Expression::compile(text).getInstructions().size(); }),
+					   measure([&text] { sink = compiled::Expression::compile(compiled::SyntaxTree::parse(text)).getInstructions().size(); }));
+		}
+	}
+
+	//	the evaluation loop as it was before the superinstructions, one instruction at a time over the operand stack
+	token::operand::Ptr evaluateUnfused(const compiled::Expression& statement, const compiled::Bindings& bindings)
+	{
+		std::vector<token::operand::Ptr> operands;
+		operands.reserve(statement.getInstructions().size());
+
+		for (const auto& instruction : statement.getInstructions())
+		{
+			switch (instruction.code)
+			{
+				case compiled::Instruction::Code::Constant:
+					operands.push_back(instruction.constant);
+					break;
+
+				case compiled::Instruction::Code::Variable:
+					if (instruction.slot < bindings.size() && bindings[instruction.slot])
+						operands.push_back(bindings[instruction.slot]);
+					break;
+
+				case compiled::Instruction::Code::Operation:
+					compiled::apply(instruction.operation, operands);
+					break;
+			}
+		}
+
+		return operands.back();
+	}
+
+	//	the frequency of every pair of adjacent instructions over a sample of formulas, from which the superinstructions
+	//	were chosen, and the formulas evaluated one instruction at a time and with the superinstructions
+	void fusion(std::ostream& output)
+	{
+		const std::vector<std::string_view> corpus {
+			"price * quantity - price * quantity * discount + shipping > limit", "(x - m) / s + Log10(y + 1) * 3", "Sqrt(x * x + y * y) <= r",
+			"x * 1.15 - 0.01", "a + b > 100 AndAlso c <> 0", "Exp(-x * x / 2) / Sqrt(2 * pi)", "Abs(x - y) <= 0.001 OrElse x = y",
+			"(a * 3 + b * 2 + c) / 6", "Log(x) * 2 + Sin(y) - Cos(z)", "x ^ 2 + y ^ 2 < r ^ 2", "Round(total * 0.2) + fee",
+			"score >= 50 And Not flagged", "(high - low) / close * 100", "Floor(age / 10) * 10 + bucket", "balance * (1 + rate / 12) ^ months"
+		};
+
+		const auto kindOf = [] (const compiled::Instruction& instruction) -> std::string {
+			switch (instruction.code)
+			{
+				case compiled::Instruction::Code::Constant:		return "constant";
+				case compiled::Instruction::Code::Variable:		return "variable";
+				default:										return instruction.operation.arity > 1 ? "binary" : "unary";
+			}
+		};
+
+		std::vector<std::pair<std::string, std::size_t>> pairs;
+		auto total = std::size_t(0);
+
+		std::vector<compiled::Expression> statements;
+		std::vector<compiled::Bindings> bindings;
+
+		for (const auto formula : corpus)
+		{
+			statements.push_back(compiled::Expression::compile(formula));
+			const auto& instructions = statements.back().getInstructions();
+
+			for (auto i = std::size_t(1); i < instructions.size(); ++i, ++total)
+			{
+				const auto pair = kindOf(instructions[i - 1]) + " " + kindOf(instructions[i]);
+				const auto found = std::find_if(pairs.begin(), pairs.end(), [&pair] (const auto& counted) { return counted.first == pair; });
+
+				if (found == pairs.end())
+					pairs.push_back({pair, 1});
+				else
+					++found->second;
+			}
+
+			bindings.emplace_back(statements.back().getAliases().size());
+			for (auto slot = std::size_t(0); slot < bindings.back().size(); ++slot)
+				bindings.back()[slot] = std::make_shared<token::operand::Float>(1.25 + slot);
+		}
+
+		std::sort(pairs.begin(), pairs.end(), [] (const auto& left, const auto& right) { return left.second > right.second; });
+		for (const auto& [pair, count] : pairs)
+			output << pair << ": " << 100.0 * count / total << "%\n";
+
+		for (auto i = std::size_t(0); i < corpus.size(); i += 4)
+			report(output, corpus[i],
+				   measure([&] { sink = evaluateUnfused(statements[i], bindings[i]) != nullptr; }),
+				   measure([&] { sink = statements[i].evaluate(bindings[i]) != nullptr; }));
+
+		report(output, "whole sample",
+			   measure([&] {
+				   for (auto i = std::size_t(0); i < statements.size(); ++i)
+					   sink = evaluateUnfused(statements[i], bindings[i]) != nullptr;
+			   }),
+			   measure([&] {
+				   for (auto i = std::size_t(0); i < statements.size(); ++i)
+					   sink = statements[i].evaluate(bindings[i]) != nullptr;
+			   }));
+	}
+
+	//	evaluations without limits and within a budget checking all of them, for the cost of counting operations
+	void budget(std::ostream& output)
+	{
+		compiled::Limits limits;
+		limits.maxLength = 1 << 20;
+		limits.maxDepth = 64;
+		limits.maxOperations = std::size_t(1) << 40;
+		limits.timeout = std::chrono::hours(1);
+
+		for (const auto formula : {"x * 2 + y", "(x - 3) / y + Sqrt(x * x + y * y) - Sin(x) * Cos(y) + x ^ 3 > 2.5 OrElse y < 0"})
+		{
+			const auto statement = compiled::Expression::compile(formula);
+			const auto bindings = statement.bind(compiled::parseVariables("x = 1.5 y = 2;"));
+			compiled::Budget budget(limits, {});
+
+			report(output, formula,
+				   measure([&statement, &bindings] { sink = statement.evaluate(bindings) != nullptr; }),
+				   measure([&statement, &bindings, &budget] { sink = statement.evaluate(bindings, budget) != nullptr; }));
+		}
+	}
+
+	//	runs 'lookups' on 'readers' threads while 'publish' is called every millisecond, and returns the mean time per
+	//	lookup in nanoseconds on one reader; 'lookups' loops until its argument turns false and returns how many it did
+	template <typename Publish, typename Lookups>
+	double contend(unsigned readers, Publish&& publish, Lookups&& lookups)
+	{
+		std::atomic<bool> running(true);
+		std::atomic<std::size_t> total(0);
+		std::vector<std::thread> threads;
+
+		const auto start = Clock::now();
+		for (auto i = 0u; i < readers; ++i)
+			threads.emplace_back([&running, &total, &lookups] { total += lookups(running); });
+
+		while (Clock::now() - start < std::chrono::milliseconds(300))
+		{
+			publish();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		running = false;
+		for (auto& thread : threads)
+			thread.join();
+
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() * readers / total;
+	}
+
+	//	lookups from a reader on every core while a writer reloads the whole set every millisecond, with the set
+	//	behind a mutex and a shared_ptr against the registry
+	void registry(std::ostream& output)
+	{
+		const auto readers = std::max(1u, std::thread::hardware_concurrency());
+
+		compiled::Registry::Formulas formulas;
+		std::vector<std::string> names;
+		for (auto i = 0; i < 100; ++i)
+		{
+			names.push_back("pricing.v" + std::to_string(i));
+			formulas.emplace_back(names.back(), compiled::Expression::compile("x * " + std::to_string(i) + " + 1"));
+		}
+
+		std::mutex mutex;
+		auto locked = std::make_shared<const compiled::Registry::Version>(formulas, 0);
+		auto version = std::uint64_t(0);
+
+		compiled::Registry registry;
+		registry.publish(formulas);
+
+		report(output, std::to_string(readers) + " readers",
+			   contend(readers,
+					   [&] {
+						   auto next = std::make_shared<const compiled::Registry::Version>(formulas, ++version);
+						   std::lock_guard<std::mutex> lock(mutex);
+						   locked.swap(next);
+					   },
+					   [&] (const std::atomic<bool>& running) {
+						   auto count = std::size_t(0);
+						   for (; running.load(std::memory_order_relaxed); ++count)
+						   {
+							   std::shared_ptr<const compiled::Registry::Version> snapshot;
+							   {
+								   std::lock_guard<std::mutex> lock(mutex);
+								   snapshot = locked;
+							   }
+							   sink = snapshot->find(names[count % names.size()]) != nullptr;
+						   }
+						   return count;
+					   }),
+			   contend(readers,
+					   [&] { registry.publish(formulas); },
+					   [&] (const std::atomic<bool>& running) {
+						   compiled::Registry::Reader reader(registry);
+						   auto count = std::size_t(0);
+						   for (; running.load(std::memory_order_relaxed); ++count)
+						   {
+							   const compiled::Registry::Snapshot snapshot(reader);
+							   sink = snapshot->find(names[count % names.size()]) != nullptr;
+						   }
+						   return count;
+					   }));
+	}
+
+	//	per formula: compiling the baseline tier against the full pipeline, evaluating the optimized tier against the
+	//	baseline one, and a promoted TieredExpression against the Expression it runs, for the cost of counting
+	void tiering(std::ostream& output)
+	{
+		for (const auto formula : {"x * 2 + y", "x ^ (1 + 1) / (2 ^ 2) + y * (3 * 0.5) - Sqrt(16) * x", "(x - 3) / y + Sqrt(x * x + y * y) - Sin(x) * Cos(y) + x ^ 3 > 2.5 OrElse y < 0"})
+		{
+			const auto baseline = compiled::Expression::compileBaseline(formula);
+			const auto optimized = baseline.optimize();
+			const auto bindings = baseline.bind(compiled::parseVariables("x = 1.5 y = 2;"));
+
+			compiled::TieredExpression tiered(formula, 0);
+
+			report(output, std::string("compile ") + formula,
+				   measure([formula] { sink = compiled::Expression::compile(formula).getInstructions().size(); }),
+				   measure([formula] { sink = compiled::Expression::compileBaseline(formula).getInstructions().size(); }));
+
+			report(output, std::string("evaluate ") + formula,
+				   measure([&baseline, &bindings] { sink = baseline.evaluate(bindings) != nullptr; }),
+				   measure([&optimized, &bindings] { sink = optimized.evaluate(bindings) != nullptr; }));
+
+			report(output, std::string("counted ") + formula,
+				   measure([&optimized, &bindings] { sink = optimized.evaluate(bindings) != nullptr; }),
+				   measure([&tiered, &bindings] { sink = tiered.evaluate(bindings) != nullptr; }));
+		}
+	}
+
+	//	per row, the way wrappers called the evaluator before the C interface, with the values formatted into the text of
+	//	every call, against one batched call over the columns, typed and as text
+	void interface(std::ostream& output)
+	{
+		const auto rows = std::size_t(1000);
+		const std::string formula = "price * quantity * (1 - discount) + 2";
+
+		std::vector<double> prices, discounts;
+		std::vector<std::int64_t> quantities;
+		for (auto row = std::size_t(0); row < rows; ++row)
+		{
+			prices.push_back(1 + row % 97 * 0.25);
+			quantities.push_back(static_cast<std::int64_t>(row % 13));
+			discounts.push_back(row % 5 * 0.05);
+		}
+
+		const vbe_column columns[] {
+			{"price", 5, VBE_FLOAT, prices.data()},
+			{"quantity", 8, VBE_INTEGER, quantities.data()},
+			{"discount", 8, VBE_FLOAT, discounts.data()}
+		};
+
+		const auto context = vbe_context_create();
+		vbe_expression* expression = nullptr;
+		vbe_compile(context, formula.data(), formula.size(), &expression);
+
+		std::vector<vbe_value> values(rows);
+		std::vector<char> text(rows * 32);
+		std::vector<std::size_t> offsets(rows + 1);
+		auto length = std::size_t(0);
+
+		const auto perRow = measure([&] {
+			for (auto row = std::size_t(0); row < rows; ++row)
+			{
+				const auto source = "price = " + std::to_string(prices[row]) + " quantity = " + std::to_string(quantities[row])
+									+ " discount = " + std::to_string(discounts[row]) + "; " + formula;
+				const auto statement = compiled::Expression::compile(source);
+				sink = statement.evaluate(statement.bind(compiled::parseVariables(source)))->toString().size();
+			}
+		}) / rows;
+
+		report(output, "typed", perRow, measure([&] { sink = vbe_evaluate(context, expression, columns, 3, rows, values.data()); }) / rows);
+		report(output, "text", perRow, measure([&] { sink = vbe_evaluate_text(context, expression, columns, 3, rows, text.data(), text.size(), offsets.data(), &length); }) / rows);
+
+		vbe_expression_destroy(expression);
+		vbe_context_destroy(context);
+	}
+
+	struct Benchmark
+	{
+		std::string_view name;
+		void (*run)(std::ostream& output);
+	};
+
+	const std::vector<Benchmark> Benchmarks
+	{
+		{"scanning", scanning},
+		{"budget", budget},
+		{"catalogue", catalogue},
+		{"cost", cost},
+		{"currency", currency},
+		{"editing", editing},
+		{"filter", filter},
+		{"fusion", fusion},
+		{"functions", functions},
+		{"gradient", gradient},
+		{"interface", interface},
+		{"memo", memo},
+		{"parsing", parsing},
+		{"registry", registry},
+		{"strength", strength},
+		{"tiering", tiering},
+		{"zones", zones}
+	};
+}
+
+void benchmark::run(std::ostream& output, std::string_view filter)
+{
+	for (const auto& benchmark : Benchmarks)
+	{
+		if (benchmark.name.find(filter) == std::string_view::npos)
+			continue;
+
+		output << "[" << benchmark.name << "]\n";
+		benchmark.run(output);
+	}
+}
@@ -0,0 +1,13 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <ostream>
+#include <string_view>
+
+namespace benchmark
+{
+	//	runs the microbenchmarks whose name contains 'filter' and prints one line per measurement
+	void run(std::ostream& output, std::string_view filter = {});
+}
+
+#endif
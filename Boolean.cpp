@@ -3,7 +3,6 @@
 #include "Utils.h"
 
 #include <vector>
-#include <cctype>
 
 token::operand::Boolean::Boolean() : Boolean(false)
 { }
@@ -20,7 +19,7 @@ std::optional<std::string_view> token::operand::Boolean::parse(std::string_view
 
 	const auto& [prefix, boolean] = found.value();
 
-	if (utils::str::charAfterPrefix(expression, prefix, std::isalnum)) 
+	if (utils::str::charAfterPrefix(expression, prefix, [] (char ch) { return utils::str::isClass(ch, utils::str::Alpha | utils::str::Digit); }))
 		return {};
 
 	context.lastToken = Context::TokenType::Operand;
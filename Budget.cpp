@@ -0,0 +1,79 @@
+#include "Budget.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+compiled::CancellationToken::CancellationToken()
+	:
+	cancelled(std::make_shared<std::atomic<bool>>(false))
+{ }
+
+void compiled::CancellationToken::cancel() const
+{
+	cancelled->store(true, std::memory_order_relaxed);
+}
+
+bool compiled::CancellationToken::isCancelled() const
+{
+	return cancelled->load(std::memory_order_relaxed);
+}
+
+compiled::Limits::Limits()
+	:
+	maxLength(0),
+	maxDepth(0),
+	maxOperations(0),
+	timeout(0)
+{ }
+
+compiled::Budget::Budget(const Limits& limits)
+	:
+	limits(limits),
+	deadline(limits.timeout.count() != 0 ? std::chrono::steady_clock::now() + limits.timeout : std::chrono::steady_clock::time_point()),
+	spent(0),
+	interval(limits.maxOperations != 0 ? std::min(CheckInterval, limits.maxOperations + 1) : CheckInterval),
+	untilCheck(interval)
+{ }
+
+compiled::Budget::Budget(const Limits& limits, CancellationToken token)
+	:
+	Budget(limits)
+{
+	this->token = std::move(token);
+}
+
+void compiled::Budget::checkLength(std::size_t length) const
+{
+	if (limits.maxLength != 0 && length > limits.maxLength)
+		throw std::runtime_error("Expression longer than " + std::to_string(limits.maxLength) + " characters");
+}
+
+void compiled::Budget::checkDepth(std::size_t depth) const
+{
+	if (limits.maxDepth != 0 && depth > limits.maxDepth)
+		throw std::runtime_error("Expression nested more than " + std::to_string(limits.maxDepth) + " levels deep");
+}
+
+void compiled::Budget::checkTime() const
+{
+	if (token && token->isCancelled())
+		throw std::runtime_error("Cancelled");
+
+	if (limits.timeout.count() != 0 && std::chrono::steady_clock::now() > deadline)
+		throw std::runtime_error("Deadline exceeded");
+}
+
+//	the interval ends one operation past the limit, so the operation that exceeds it is the one that throws
+void compiled::Budget::check()
+{
+	spent += interval;
+	checkTime();
+
+	if (limits.maxOperations != 0 && spent > limits.maxOperations)
+		throw std::runtime_error("Evaluation exceeded " + std::to_string(limits.maxOperations) + " operations");
+
+	interval = limits.maxOperations != 0 ? std::min(CheckInterval, limits.maxOperations + 1 - spent) : CheckInterval;
+	untilCheck = interval;
+}
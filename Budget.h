@@ -0,0 +1,74 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace compiled
+{
+	//	shared by the thread compiling or evaluating a formula and any thread that may cancel it
+	class CancellationToken
+	{
+		public:
+			CancellationToken();
+
+			//	safe to call from any thread: what runs under the token throws "Cancelled" at its next check
+			void cancel() const;
+			bool isCancelled() const;
+
+		private:
+			std::shared_ptr<std::atomic<bool>> cancelled;
+	};
+
+	//	what a formula from an untrusted source may use, each limit off when 0
+	struct Limits
+	{
+		Limits();
+
+		std::size_t maxLength;				//	characters of the whole expression, preamble included
+		std::size_t maxDepth;				//	parentheses open at once
+		std::size_t maxOperations;			//	operations executed by one evaluation
+		std::chrono::nanoseconds timeout;	//	for compiling and evaluating, from the creation of the budget
+	};
+
+	//	the limits applied to one request as it compiles and evaluates
+	//
+	//	the cancellation token, the deadline and the operation count are checked together every CheckInterval operations
+	//	(or tokens, when compiling), so counting an operation only decrements a counter; an exhausted budget throws
+	class Budget
+	{
+		public:
+			static constexpr std::size_t CheckInterval = 256;
+
+			explicit Budget(const Limits& limits);
+			Budget(const Limits& limits, CancellationToken token);
+
+			void checkLength(std::size_t length) const;
+			void checkDepth(std::size_t depth) const;
+
+			//	the cancellation token and the deadline
+			void checkTime() const;
+
+			//	counts one operation executed
+			void spend()
+			{
+				if (--untilCheck == 0)
+					check();
+			}
+
+		private:
+			void check();
+
+			Limits limits;
+			std::optional<CancellationToken> token;
+			std::chrono::steady_clock::time_point deadline;
+			std::size_t spent;			//	operations counted up to the last check
+			std::size_t interval;		//	operations between the last check and the next
+			std::size_t untilCheck;
+	};
+}
+
+#endif
@@ -0,0 +1,294 @@
+#include "CInterface.h"
+
+#include "Boolean.h"
+#include "Currency.h"
+#include "Expression.h"
+#include "Float.h"
+#include "Integer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+struct vbe_context
+{
+	std::string error;
+	compiled::Bindings bindings;
+	std::vector<std::pair<std::size_t, const vbe_column*>> columns;		//	slot and the column bound to it
+};
+
+struct vbe_expression
+{
+	compiled::Expression statement;
+	compiled::Bindings defaults;		//	from the preamble
+};
+
+namespace
+{
+	//	reported as VBE_INVALID_ARGUMENT
+	struct InvalidArgument : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	void setError(vbe_context& context, const char* message) noexcept
+	{
+		try {
+			context.error = message;
+		}
+		catch (...) {
+			context.error.clear();
+		}
+	}
+
+	//	runs the body of a call, turning whatever it throws into a status and the message of the context
+	template <typename Call>
+	vbe_status guarded(vbe_context* context, Call&& call) noexcept
+	{
+		if (!context)
+			return VBE_INVALID_ARGUMENT;
+
+		context->error.clear();
+
+		try {
+			return call(*context);
+		}
+		catch (const InvalidArgument& e) {
+			setError(*context, e.what());
+			return VBE_INVALID_ARGUMENT;
+		}
+		catch (const std::bad_alloc&) {
+			setError(*context, "Out of memory");
+			return VBE_OUT_OF_MEMORY;
+		}
+		catch (const std::exception& e) {
+			setError(*context, e.what());
+			return VBE_ERROR;
+		}
+		catch (...) {
+			setError(*context, "Unknown error");
+			return VBE_ERROR;
+		}
+	}
+
+	token::operand::Ptr valueOf(const vbe_column& column, std::size_t row)
+	{
+		switch (column.type)
+		{
+			case VBE_INTEGER:	return std::make_shared<token::operand::Integer>(static_cast<const std::int64_t*>(column.values)[row]);
+			case VBE_FLOAT:		return std::make_shared<token::operand::Float>(static_cast<const double*>(column.values)[row]);
+			case VBE_BOOLEAN:	return std::make_shared<token::operand::Boolean>(static_cast<const std::uint8_t*>(column.values)[row] != 0);
+			case VBE_CURRENCY:	return std::make_shared<token::operand::Currency>(static_cast<const std::int64_t*>(column.values)[row]);
+			default:			throw InvalidArgument("Invalid column type");
+		}
+	}
+
+	//	binds the columns to the slots of the expression, with the preamble giving the slots no column binds
+	void bindColumns(vbe_context& context, const vbe_expression& expression, const vbe_column* columns, std::size_t columnCount, std::size_t rows)
+	{
+		if (columnCount != 0 && !columns)
+			throw InvalidArgument("No columns");
+
+		context.bindings = expression.defaults;
+		context.columns.clear();
+
+		for (auto i = std::size_t(0); i < columnCount; ++i)
+		{
+			const auto& column = columns[i];
+
+			if ((!column.name && column.nameLength != 0) || (!column.values && rows != 0))
+				throw InvalidArgument("Column " + std::to_string(i) + " has no name or no values");
+			if (column.type < VBE_INTEGER || column.type > VBE_CURRENCY)
+				throw InvalidArgument("Column " + std::to_string(i) + " has an invalid type");
+
+			if (const auto slot = expression.statement.slotOf(std::string_view(column.name, column.nameLength)))
+				context.columns.emplace_back(slot.value(), &column);
+		}
+
+		for (auto slot = std::size_t(0); slot < context.bindings.size(); ++slot)
+		{
+			const auto bound = [slot] (const auto& column) { return column.first == slot; };
+
+			if (!context.bindings[slot] && std::none_of(std::begin(context.columns), std::end(context.columns), bound))
+				throw std::runtime_error("No column or value for variable '" + expression.statement.getAliases()[slot] + "'");
+		}
+	}
+
+	//	evaluates every row and converts its result with 'format', handing 'write' the row and what 'format' made of
+	//	it, or nullptr and the message of the failure to evaluate or to format the row; returns the message of the
+	//	first failure, if any
+	template <typename Format, typename Write>
+	std::string evaluateRows(vbe_context& context, const vbe_expression& expression, std::size_t rows, Format&& format, Write&& write)
+	{
+		std::string failure;
+
+		for (auto row = std::size_t(0); row < rows; ++row)
+		{
+			for (const auto& [slot, column] : context.columns)
+				context.bindings[slot] = valueOf(*column, row);
+
+			std::optional<decltype(format(token::operand::Ptr()))> formatted;
+
+			try {
+				formatted = format(expression.statement.evaluate(context.bindings));
+			}
+			catch (const std::bad_alloc&) {
+				throw;
+			}
+			catch (const std::exception& e) {
+				if (failure.empty())
+					failure = e.what();
+
+				write(row, nullptr, e.what());
+				continue;
+			}
+
+			write(row, &*formatted, nullptr);
+		}
+
+		return failure;
+	}
+
+	vbe_value typedValue(const token::operand::Ptr& result)
+	{
+		vbe_value value {};
+
+		if (const auto currency = dynamic_cast<const token::operand::Currency*>(result.get())) {
+			value.type = VBE_CURRENCY;
+			value.value.integer = currency->getScaled();
+		}
+		else if (const auto number = result->getValue(); std::holds_alternative<double>(number)) {
+			value.type = VBE_FLOAT;
+			value.value.real = std::get<double>(number);
+		}
+		else {
+			value.type = dynamic_cast<const token::operand::Boolean*>(result.get()) ? VBE_BOOLEAN : VBE_INTEGER;
+			value.value.integer = std::get<long long>(number);
+		}
+
+		return value;
+	}
+}
+
+uint32_t vbe_abi_version(void)
+{
+	return VBE_ABI_VERSION;
+}
+
+vbe_context* vbe_context_create(void)
+{
+	return new (std::nothrow) vbe_context();
+}
+
+void vbe_context_destroy(vbe_context* context)
+{
+	delete context;
+}
+
+const char* vbe_context_error(const vbe_context* context)
+{
+	return context ? context->error.c_str() : "";
+}
+
+vbe_status vbe_compile(vbe_context* context, const char* text, size_t length, vbe_expression** expression)
+{
+	return guarded(context, [=] (vbe_context&) {
+		if ((!text && length != 0) || !expression)
+			throw InvalidArgument("No text or no expression to compile it to");
+
+		*expression = nullptr;
+
+		const auto source = std::string_view(text, length);
+		auto statement = compiled::Expression::compile(source);
+		auto defaults = statement.bind(compiled::parseVariables(source));
+
+		*expression = new vbe_expression {std::move(statement), std::move(defaults)};
+		return VBE_OK;
+	});
+}
+
+void vbe_expression_destroy(vbe_expression* expression)
+{
+	delete expression;
+}
+
+size_t vbe_expression_variables(const vbe_expression* expression)
+{
+	return expression ? expression->statement.getAliases().size() : 0;
+}
+
+const char* vbe_expression_variable(const vbe_expression* expression, size_t index, size_t* length)
+{
+	if (!expression || index >= expression->statement.getAliases().size())
+		return nullptr;
+
+	const auto& alias = expression->statement.getAliases()[index];
+	if (length)
+		*length = alias.size();
+	return alias.c_str();
+}
+
+vbe_status vbe_evaluate(vbe_context* context, const vbe_expression* expression, const vbe_column* columns, size_t columnCount,
+						size_t rows, vbe_value* results)
+{
+	return guarded(context, [=] (vbe_context& context) {
+		if (!expression || (!results && rows != 0))
+			throw InvalidArgument("No expression or no results");
+
+		bindColumns(context, *expression, columns, columnCount, rows);
+
+		const auto failure = evaluateRows(context, *expression, rows, typedValue, [results] (std::size_t row, const vbe_value* value, const char*) {
+			results[row] = value ? *value : vbe_value {VBE_FAILED, {0}};
+		});
+
+		if (failure.empty())
+			return VBE_OK;
+
+		context.error = failure;
+		return VBE_ERROR;
+	});
+}
+
+vbe_status vbe_evaluate_text(vbe_context* context, const vbe_expression* expression, const vbe_column* columns, size_t columnCount,
+							 size_t rows, char* text, size_t capacity, size_t* offsets, size_t* length)
+{
+	return guarded(context, [=] (vbe_context& context) {
+		if (!expression || !offsets || !length || (!text && capacity != 0))
+			throw InvalidArgument("No expression, offsets, length or text");
+
+		bindColumns(context, *expression, columns, columnCount, rows);
+
+		auto written = std::size_t(0);
+		offsets[0] = 0;
+
+		const auto format = [] (const token::operand::Ptr& result) { return result->toString(); };
+
+		const auto failure = evaluateRows(context, *expression, rows, format, [&] (std::size_t row, const std::string* result, const char* error) {
+			const auto formatted = result ? std::string_view(*result) : std::string_view(error);
+
+			if (formatted.size() <= capacity && written <= capacity - formatted.size())
+				std::memcpy(text + written, formatted.data(), formatted.size());
+
+			written += formatted.size();
+			offsets[row + 1] = written;
+		});
+
+		*length = written;
+
+		if (written > capacity)
+			return VBE_BUFFER_TOO_SMALL;
+		if (failure.empty())
+			return VBE_OK;
+
+		context.error = failure;
+		return VBE_ERROR;
+	});
+}
@@ -0,0 +1,112 @@
+#ifndef C_INTERFACE_H
+#define C_INTERFACE_H
+
+//	C interface to compile and evaluate expressions from other languages, built into a shared library with the rest
+//	of the sources (and VBE_BUILDING_LIBRARY defined, on Windows)
+//
+//	no exception crosses it: every call that can fail returns a vbe_status, and leaves the message of the failure in
+//	its context. A compiled expression never changes, so any number of threads may evaluate it at once, each with a
+//	context of its own; a context must not be used by two threads at the same time
+//
+//	inputs are read where the caller keeps them, one array per column, and results are written to arrays the caller
+//	owns, one call for all the rows
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#	if defined(VBE_BUILDING_LIBRARY)
+#		define VBE_API __declspec(dllexport)
+#	else
+#		define VBE_API __declspec(dllimport)
+#	endif
+#else
+#	define VBE_API __attribute__((visibility("default")))
+#endif
+
+//	raised only when the layout of a type below or the meaning of a call changes
+#define VBE_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vbe_context vbe_context;
+typedef struct vbe_expression vbe_expression;
+
+typedef enum vbe_status
+{
+	VBE_OK = 0,
+	VBE_ERROR = 1,					//	the message is in the context
+	VBE_INVALID_ARGUMENT = 2,
+	VBE_OUT_OF_MEMORY = 3,
+	VBE_BUFFER_TOO_SMALL = 4
+} vbe_status;
+
+typedef enum vbe_type
+{
+	VBE_INTEGER = 0,				//	int64_t
+	VBE_FLOAT = 1,					//	double
+	VBE_BOOLEAN = 2,				//	uint8_t in a column, 0 for False; -1 or 0 in a result, as in VBA
+	VBE_CURRENCY = 3,				//	int64_t, the value times 10000
+	VBE_FAILED = 4					//	a result whose evaluation failed
+} vbe_type;
+
+//	the values of one variable, one per row, in the representation of its type
+typedef struct vbe_column
+{
+	const char* name;
+	size_t nameLength;
+	int32_t type;					//	vbe_type, VBE_FAILED aside
+	const void* values;
+} vbe_column;
+
+typedef struct vbe_value
+{
+	int32_t type;					//	vbe_type
+	union
+	{
+		int64_t integer;			//	VBE_INTEGER, VBE_BOOLEAN, VBE_CURRENCY
+		double real;				//	VBE_FLOAT
+	} value;
+} vbe_value;
+
+VBE_API uint32_t vbe_abi_version(void);
+
+//	NULL when out of memory
+VBE_API vbe_context* vbe_context_create(void);
+VBE_API void vbe_context_destroy(vbe_context* context);
+
+//	the message of the last call on the context that failed, "" if none has; valid until the next call on the context
+VBE_API const char* vbe_context_error(const vbe_context* context);
+
+//	compiles 'length' characters of text, with the preamble (if any) giving the values of the variables no column binds
+VBE_API vbe_status vbe_compile(vbe_context* context, const char* text, size_t length, vbe_expression** expression);
+VBE_API void vbe_expression_destroy(vbe_expression* expression);
+
+//	the variables of the expression, in slot order
+VBE_API size_t vbe_expression_variables(const vbe_expression* expression);
+VBE_API const char* vbe_expression_variable(const vbe_expression* expression, size_t index, size_t* length);
+
+//	evaluates the expression once for each of 'rows' rows, binding every column to the variable of the same name
+//	(columns naming no variable are ignored), and writes the result of row i to results[i]
+//
+//	a row that fails gets a VBE_FAILED result, the other rows are still evaluated, and the call returns VBE_ERROR
+//	with the message of the first failure
+VBE_API vbe_status vbe_evaluate(vbe_context* context, const vbe_expression* expression, const vbe_column* columns, size_t columnCount,
+								size_t rows, vbe_value* results);
+
+//	the same, writing the results as text, as VBA formats them, one after the other into 'text' without separators:
+//	row i is text[offsets[i]] up to text[offsets[i + 1]], so 'offsets' has room for rows + 1 entries, and a failed
+//	row holds its error message
+//
+//	'length' receives the bytes all the results take, and 'offsets' is filled in any case; when that's more than
+//	'capacity', only the rows that fit are written and the call returns VBE_BUFFER_TOO_SMALL
+VBE_API vbe_status vbe_evaluate_text(vbe_context* context, const vbe_expression* expression, const vbe_column* columns, size_t columnCount,
+									 size_t rows, char* text, size_t capacity, size_t* offsets, size_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
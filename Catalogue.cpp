@@ -0,0 +1,319 @@
+#include "Catalogue.h"
+
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	//	a constant operand as allocated by make_shared: the object and its reference counts
+	constexpr std::size_t ConstantBytes = sizeof(token::operand::Float) + 2 * sizeof(long);
+
+	constexpr auto None = ~std::size_t(0);
+
+	//	identifies a node by its code, its own fields and the nodes it reads, so equal subtrees get equal keys
+	std::string keyOf(const compiled::Catalogue::Node& node)
+	{
+		std::string key(1, static_cast<char>(node.code));
+
+		switch (node.code)
+		{
+			case compiled::Instruction::Code::Constant: {
+				const auto constant = node.constant->getValue();
+				auto bits = std::uint64_t(0);
+
+				if (const auto currency = dynamic_cast<const token::operand::Currency*>(node.constant.get())) {
+					key += 'c';
+					bits = static_cast<std::uint64_t>(currency->getScaled());
+				}
+				else if (const auto integer = std::get_if<long long>(&constant)) {
+					key += dynamic_cast<const token::operand::Boolean*>(node.constant.get()) ? 'b' : 'i';
+					bits = static_cast<std::uint64_t>(*integer);
+				}
+				else {
+					key += 'f';
+					std::memcpy(&bits, &std::get<double>(constant), sizeof(bits));
+				}
+
+				utils::bytes::store64(key, bits);
+				break;
+			}
+
+			case compiled::Instruction::Code::Variable:
+				utils::bytes::store64(key, node.slot);
+				break;
+
+			case compiled::Instruction::Code::Operation:
+				key += static_cast<char>(node.operation.type);
+				key += static_cast<char>(node.operation.precedence);
+				key += static_cast<char>(node.operation.arity);
+				utils::bytes::store64(key, node.operands[0]);
+				utils::bytes::store64(key, node.operands[1]);
+				break;
+		}
+
+		return key;
+	}
+
+	std::size_t arityOf(const token::Operator& operation)
+	{
+		return static_cast<std::size_t>(std::max(operation.arity, 1));
+	}
+
+	//	true when the program reduces to exactly one tree, with every operation finding its operands
+	bool isTree(const std::vector<compiled::Instruction>& instructions)
+	{
+		auto depth = std::size_t(0);
+
+		for (const auto& instruction : instructions)
+		{
+			if (instruction.code != compiled::Instruction::Code::Operation)
+				++depth;
+			else if (depth < arityOf(instruction.operation))
+				return false;
+			else
+				depth -= arityOf(instruction.operation) - 1;
+		}
+
+		return depth == 1;
+	}
+}
+
+std::size_t compiled::Catalogue::add(std::string name, std::string_view expression)
+{
+	const auto statement = Expression::compile(expression);
+
+	Formula formula {std::move(name), None, {}, {}};
+
+	for (const auto& alias : statement.getAliases())
+		formula.slots.push_back(addSlot(alias));
+
+	instructionCount += statement.getInstructions().size();
+	constantCount += std::count_if(std::begin(statement.getInstructions()), std::end(statement.getInstructions()),
+								   [] (const Instruction& instruction) { return instruction.code == Instruction::Code::Constant; });
+
+	if (!isTree(statement.getInstructions()))
+		formula.irregular = statement;
+	else {
+		std::vector<std::size_t> operands;
+
+		for (const auto& instruction : statement.getInstructions())
+		{
+			Node node {instruction.code, instruction.constant, 0, instruction.operation, {None, None}};
+
+			if (instruction.code == Instruction::Code::Variable)
+				node.slot = formula.slots[instruction.slot];
+			else if (instruction.code == Instruction::Code::Operation) {
+				const auto arity = arityOf(instruction.operation);
+
+				std::copy(std::end(operands) - arity, std::end(operands), node.operands);
+				operands.resize(operands.size() - arity);
+			}
+
+			operands.push_back(intern(node));
+		}
+
+		formula.root = operands.back();
+		formula.slots.clear();
+	}
+
+	formulas.push_back(std::move(formula));
+	return formulas.size() - 1;
+}
+
+compiled::Bindings compiled::Catalogue::bind(const std::vector<token::Variable>& vars) const
+{
+	Bindings bindings(aliases.size());
+
+	for (auto slot = 0u; slot < aliases.size(); ++slot)
+	{
+		const auto found = std::find_if(std::begin(vars), std::end(vars),
+										[this, slot] (const token::Variable& var) { return aliases[slot] == var.alias; });
+
+		if (found != std::end(vars))
+			bindings[slot] = found->operand;
+	}
+
+	return bindings;
+}
+
+std::vector<compiled::Catalogue::Result> compiled::Catalogue::evaluate(const Bindings& bindings) const
+{
+	//	a node has either a value, an error, or neither when it reads an unbound variable
+	std::vector<token::operand::Ptr> values(nodes.size());
+	std::vector<std::string> errors(nodes.size());
+
+	//	operands always precede the operations that read them, so one pass in order suffices
+	for (auto i = std::size_t(0); i < nodes.size(); ++i)
+	{
+		const auto& node = nodes[i];
+
+		switch (node.code)
+		{
+			case Instruction::Code::Constant:
+				values[i] = node.constant;
+				break;
+
+			case Instruction::Code::Variable:
+				if (node.slot < bindings.size())
+					values[i] = bindings[node.slot];
+				break;
+
+			case Instruction::Code::Operation: {
+				const auto arity = arityOf(node.operation);
+				const auto first = node.operands, last = node.operands + arity;
+
+				if (std::any_of(first, last, [&values, &errors] (std::size_t operand) { return !values[operand] && errors[operand].empty(); }))
+					break;
+
+				if (const auto failed = std::find_if(first, last, [&errors] (std::size_t operand) { return !errors[operand].empty(); }); failed != last) {
+					errors[i] = errors[*failed];
+					break;
+				}
+
+				try {
+					values[i] = arity == 1 ? token::Operator(node.operation).compute(values[node.operands[0]])
+										   : token::Operator(node.operation).compute(values[node.operands[0]], values[node.operands[1]]);
+				}
+				catch (const std::exception& e) {
+					errors[i] = *e.what() ? e.what() : "Evaluation failed";
+				}
+				break;
+			}
+		}
+	}
+
+	std::vector<Result> results(formulas.size());
+
+	for (auto i = std::size_t(0); i < formulas.size(); ++i)
+	{
+		const auto& formula = formulas[i];
+
+		try {
+			if (formula.irregular) {
+				Bindings local(formula.slots.size());
+				for (auto slot = std::size_t(0); slot < local.size(); ++slot)
+					local[slot] = formula.slots[slot] < bindings.size() ? bindings[formula.slots[slot]] : nullptr;
+
+				results[i].value = formula.irregular->evaluate(local);
+			}
+			else if (values[formula.root])
+				results[i].value = values[formula.root];
+			else if (!errors[formula.root].empty())
+				results[i].error = errors[formula.root];
+			else
+				results[i].value = evaluateUnbound(formula.root, values, errors);
+		}
+		catch (const std::exception& e) {
+			results[i].error = e.what();
+		}
+	}
+
+	return results;
+}
+
+std::size_t compiled::Catalogue::size() const
+{
+	return formulas.size();
+}
+
+const std::string& compiled::Catalogue::getName(std::size_t formula) const
+{
+	return formulas[formula].name;
+}
+
+std::optional<std::size_t> compiled::Catalogue::slotOf(std::string_view alias) const
+{
+	const auto found = std::find(std::begin(aliases), std::end(aliases), alias);
+	if (found == std::end(aliases)) return {};
+
+	return static_cast<std::size_t>(std::distance(std::begin(aliases), found));
+}
+
+const std::vector<std::string>& compiled::Catalogue::getAliases() const
+{
+	return aliases;
+}
+
+const std::vector<compiled::Catalogue::Node>& compiled::Catalogue::getNodes() const
+{
+	return nodes;
+}
+
+compiled::Catalogue::Statistics compiled::Catalogue::getStatistics() const
+{
+	const auto sharedConstants = std::count_if(std::begin(nodes), std::end(nodes), [] (const Node& node) { return node.code == Instruction::Code::Constant; });
+
+	auto irregularInstructions = std::size_t(0);
+	for (const auto& formula : formulas)
+		if (formula.irregular)
+			irregularInstructions += formula.irregular->getInstructions().size();
+
+	return {
+		formulas.size(),
+		instructionCount,
+		nodes.size(),
+		instructionCount * sizeof(Instruction) + constantCount * ConstantBytes,
+		nodes.size() * sizeof(Node) + sharedConstants * ConstantBytes + formulas.size() * sizeof(Formula) + irregularInstructions * sizeof(Instruction)
+	};
+}
+
+std::size_t compiled::Catalogue::intern(const Node& node)
+{
+	const auto [found, inserted] = index.try_emplace(keyOf(node), nodes.size());
+
+	if (inserted)
+		nodes.push_back(node);
+
+	return found->second;
+}
+
+std::size_t compiled::Catalogue::addSlot(std::string_view alias)
+{
+	if (const auto slot = slotOf(alias))
+		return slot.value();
+
+	aliases.emplace_back(alias);
+	return aliases.size() - 1;
+}
+
+//	a formula that reads an unbound variable runs its own program, where the variable is skipped as in Expression::evaluate
+//	subtrees that could be computed in the shared pass only push their value
+token::operand::Ptr compiled::Catalogue::evaluateUnbound(std::size_t root, const std::vector<token::operand::Ptr>& values, const std::vector<std::string>& errors) const
+{
+	std::vector<token::operand::Ptr> operands;
+	std::vector<std::pair<std::size_t, bool>> pending {{root, false}};
+
+	while (!pending.empty())
+	{
+		const auto [current, expanded] = pending.back();
+		pending.pop_back();
+
+		const auto& node = nodes[current];
+
+		if (values[current])
+			operands.push_back(values[current]);
+		else if (!errors[current].empty())
+			throw std::runtime_error(errors[current]);
+		else if (node.code != Instruction::Code::Operation)
+			continue;
+		else if (expanded)
+			apply(node.operation, operands);
+		else {
+			pending.push_back({current, true});
+			for (auto operand = arityOf(node.operation); operand-- > 0;)
+				pending.push_back({node.operands[operand], false});
+		}
+	}
+
+	if (operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	return operands.back();
+}
@@ -0,0 +1,86 @@
+#ifndef CATALOGUE_H
+#define CATALOGUE_H
+
+#include "Expression.h"
+#include "Operand.h"
+#include "Operator.h"
+#include "Variable.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace compiled
+{
+	//	many formulas compiled into one DAG, where every distinct subexpression (same operation over the same operands)
+	//	is a single node, so evaluating the whole catalogue against one set of bindings computes it once
+	class Catalogue
+	{
+		public:
+			struct Node
+			{
+				Instruction::Code code;
+				token::operand::Ptr constant;
+				std::size_t slot;
+				token::Operator operation;
+				std::size_t operands[2];
+			};
+
+			struct Result
+			{
+				token::operand::Ptr value;
+				std::string error;			//	empty when there is a value
+			};
+
+			struct Statistics
+			{
+				std::size_t formulas;
+				std::size_t instructions;		//	compiled independently
+				std::size_t nodes;				//	in the shared DAG
+				std::size_t independentBytes;	//	approximate footprint of the independent programs and their constants
+				std::size_t sharedBytes;		//	approximate footprint of the DAG and its constants
+			};
+
+			//	compiles the statement of the expression into the DAG and returns the index of the formula
+			std::size_t add(std::string name, std::string_view expression);
+
+			//	resolves every variable of the catalogue against the variables parsed from a preamble
+			Bindings bind(const std::vector<token::Variable>& vars) const;
+
+			//	one result per formula, in the order they were added, as each formula would evaluate on its own
+			std::vector<Result> evaluate(const Bindings& bindings) const;
+
+			std::size_t size() const;
+			const std::string& getName(std::size_t formula) const;
+			std::optional<std::size_t> slotOf(std::string_view alias) const;
+
+			const std::vector<std::string>& getAliases() const;
+			const std::vector<Node>& getNodes() const;
+			Statistics getStatistics() const;
+
+		private:
+			//	a formula whose program is not a single tree (leftover or missing operands) keeps its own program
+			struct Formula
+			{
+				std::string name;
+				std::size_t root;
+				std::optional<Expression> irregular;
+				std::vector<std::size_t> slots;		//	catalogue slot of every slot of the irregular program
+			};
+
+			std::size_t intern(const Node& node);
+			std::size_t addSlot(std::string_view alias);
+			token::operand::Ptr evaluateUnbound(std::size_t root, const std::vector<token::operand::Ptr>& values, const std::vector<std::string>& errors) const;
+
+			std::vector<Node> nodes;
+			std::unordered_map<std::string, std::size_t> index;
+			std::vector<Formula> formulas;
+			std::vector<std::string> aliases;
+			std::size_t instructionCount = 0, constantCount = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "Cost.h"
+
+namespace
+{
+	constexpr auto EvaluationCost = 35.0;		//	allocating the operand stack
+	constexpr auto OperandCost = 5.0;			//	pushing a constant or a variable
+	constexpr auto InlineSaving = 30.0;			//	an operation a superinstruction computes itself
+
+	//	the operations a superinstruction computes without Operator::compute, on operands that aren't Currency
+	bool isInline(token::Operator::Type type)
+	{
+		switch (type)
+		{
+			case token::Operator::Sum:
+			case token::Operator::Difference:
+			case token::Operator::Multiplication:
+			case token::Operator::FloatDivision:
+			case token::Operator::Equality:
+			case token::Operator::Inequality:
+			case token::Operator::LessThan:
+			case token::Operator::LessThanEqual:
+			case token::Operator::GreaterThan:
+			case token::Operator::GreaterThanEqual:	return true;
+
+			default:								return false;
+		}
+	}
+}
+
+double compiled::operationCost(token::Operator::Type type)
+{
+	switch (type)
+	{
+		case token::Operator::Positive:			return 5;
+
+		case token::Operator::Negative:
+		case token::Operator::Abs:				return 65;
+
+		case token::Operator::AndAlso:
+		case token::Operator::OrElse:			return 70;
+
+		case token::Operator::Asin:				return 72;
+
+		case token::Operator::Sum:
+		case token::Operator::Equality:
+		case token::Operator::Inequality:
+		case token::Operator::RightBitshift:
+		case token::Operator::Ceil:
+		case token::Operator::Not:				return 76;
+
+		case token::Operator::Mod:
+		case token::Operator::IntegerDivision:
+		case token::Operator::LessThan:
+		case token::Operator::LessThanEqual:
+		case token::Operator::GreaterThan:
+		case token::Operator::GreaterThanEqual:
+		case token::Operator::Floor:
+		case token::Operator::Acos:				return 78;
+
+		case token::Operator::Multiplication:
+		case token::Operator::And:
+		case token::Operator::Or:
+		case token::Operator::Xor:
+		case token::Operator::Sqrt:				return 80;
+
+		case token::Operator::Round:
+		case token::Operator::Truncate:			return 82;
+
+		case token::Operator::Difference:		return 84;
+
+		case token::Operator::Log:
+		case token::Operator::LeftBitshift:		return 86;
+
+		case token::Operator::Exp:
+		case token::Operator::Sin:
+		case token::Operator::Cos:				return 89;
+
+		case token::Operator::FloatDivision:	return 90;
+		case token::Operator::Log10:			return 95;
+		case token::Operator::Tan:				return 102;
+
+		case token::Operator::Power:
+		case token::Operator::IntegerPower:		return 106;
+
+		case token::Operator::Atan:				return 120;
+
+		default:								return 0;
+	}
+}
+
+//	a superinstruction reads its operands in place, so it costs its operation alone, less for one it computes itself
+double compiled::estimateCost(const Expression& expression)
+{
+	const auto& instructions = expression.getInstructions();
+	const auto superinstructions = expression.getSuperinstructions();
+
+	auto cost = EvaluationCost;
+	auto next = std::begin(superinstructions);
+
+	for (auto i = std::size_t(0); i < instructions.size(); )
+	{
+		if (next != std::end(superinstructions) && next->first == i) {
+			const auto type = instructions[i + next->second - 1].operation.type;
+			cost += operationCost(type) - (isInline(type) ? InlineSaving : 0);
+
+			i += next->second;
+			++next;
+			continue;
+		}
+
+		cost += instructions[i].code == Instruction::Code::Operation ? operationCost(instructions[i].operation.type) : OperandCost;
+		++i;
+	}
+
+	return cost;
+}
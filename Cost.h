@@ -0,0 +1,21 @@
+#ifndef COST_H
+#define COST_H
+
+#include "Expression.h"
+#include "Operator.h"
+
+namespace compiled
+{
+	//	estimated nanoseconds of one operation of the type, popping its operands and pushing its result, on Float operands
+	//
+	//	the weights are calibrated with the "cost" benchmark, which measures every operation unfused and prints it next to
+	//	its weight, then fused and next to the estimate
+	double operationCost(token::Operator::Type type);
+
+	//	estimated nanoseconds of one Expression::evaluate of the expression: the operand stack, every constant and variable
+	//	pushed and every operation, with the instructions fused into a superinstruction weighed as the step evaluate runs;
+	//	a single pass over the program, cheap enough to compute right after compiling
+	double estimateCost(const Expression& expression);
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "Currency.h"
+
+#include "Utils.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+token::operand::Currency::Currency() : Currency(0ll)
+{ }
+
+token::operand::Currency::Currency(long long scaled) : value(scaled)
+{ }
+
+std::optional<std::string_view> token::operand::Currency::parse(std::string_view expression, Context& context)
+{
+	const auto negative = !expression.empty() && expression.front() == '-';
+	const auto sign = !expression.empty() && (negative || expression.front() == '+') ? 1u : 0u;
+
+	const auto whole = expression.substr(sign, utils::str::countDigits(expression.substr(sign)));
+	auto charactersParsed = sign + whole.length();
+
+	auto fraction = std::string_view();
+	if (charactersParsed < expression.size() && expression[charactersParsed] == '.') {
+		fraction = expression.substr(charactersParsed + 1, utils::str::countDigits(expression.substr(charactersParsed + 1)));
+		charactersParsed += 1 + fraction.length();
+	}
+
+	if ((whole.empty() && fraction.empty()) || charactersParsed >= expression.size() || expression[charactersParsed] != '@')
+		return {};
+
+	const auto suffix = expression.substr(++charactersParsed);
+	if (!suffix.empty() && (utils::str::isClass(suffix.front(), utils::str::Alpha | utils::str::Digit) || suffix.front() == '.'))
+		return {};
+
+	//	the magnitude may reach 2^63 only when negative
+	const auto limit = static_cast<std::uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+	auto magnitude = std::uint64_t(0);
+
+	const auto append = [&magnitude, limit] (char digit) {
+		if (magnitude > (limit - (digit - '0')) / 10)
+			return false;
+
+		magnitude = magnitude * 10 + (digit - '0');
+		return true;
+	};
+
+	for (const auto digit : whole)
+		if (!append(digit))
+			throw std::runtime_error("Overflow");
+
+	for (auto place = std::size_t(0); place < 4; ++place)
+		if (!append(place < fraction.length() ? fraction[place] : '0'))
+			throw std::runtime_error("Overflow");
+
+	//	digits past the fourth decimal round half to even, as VBA rounds when it converts to Currency
+	if (fraction.length() > 4) {
+		const auto rest = fraction.substr(5);
+		const auto above = fraction[4] > '5' || (fraction[4] == '5' && rest.find_first_not_of('0') != std::string_view::npos);
+
+		if ((above || (fraction[4] == '5' && magnitude % 2)) && magnitude++ == limit)
+			throw std::runtime_error("Overflow");
+	}
+
+	context.lastToken = Context::TokenType::Operand;
+	value = negative ? static_cast<long long>(0 - magnitude) : static_cast<long long>(magnitude);
+	return utils::str::skipWhitespace(suffix);
+}
+
+token::operand::Type token::operand::Currency::getValue() const
+{
+	return static_cast<double>(value) / Scale;
+}
+
+std::string token::operand::Currency::toString() const
+{
+	const auto magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+	auto number = (value < 0 ? "-" : "") + std::to_string(magnitude / Scale);
+
+	if (auto fraction = magnitude % Scale) {
+		auto digits = std::to_string(fraction + Scale).substr(1);
+		digits.erase(digits.find_last_not_of('0') + 1);
+
+		number += ',' + digits;
+	}
+
+	return number;
+}
+
+bool token::operand::Currency::isCurrency() const
+{
+	return true;
+}
+
+long long token::operand::Currency::getScaled() const
+{
+	return value;
+}
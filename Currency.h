@@ -0,0 +1,34 @@
+#ifndef CURRENCY_H
+#define CURRENCY_H
+
+#include "Operand.h"
+
+namespace token::operand 
+{
+	//	VBA's Currency: a 64-bit integer count of ten-thousandths, written as a literal with an '@' suffix such as 12.50@
+	//
+	//	Sum, Difference, Multiplication, Mod and the comparisons with another Currency, an Integer or a Boolean are
+	//	computed exactly on the scaled integers and raise an overflow rather than wrap; any operation with a Float, and
+	//	those with a Float result such as '/', take the value as a Float; literals with more than four decimals round
+	//	half to even, and a literal out of range raises an overflow
+	class Currency final : public Operand
+	{
+		public:
+			static constexpr long long Scale = 10000;
+
+			Currency();
+			explicit Currency(long long scaled);
+
+			std::optional<std::string_view> parse(std::string_view expression, Context& context) override;
+			Type getValue() const override;
+			std::string toString() const override;
+			bool isCurrency() const override;
+
+			long long getScaled() const;
+
+		private:
+			long long value;
+	};
+}
+
+#endif
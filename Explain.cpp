@@ -0,0 +1,396 @@
+#include "Explain.h"
+
+#include "Boolean.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	//	an instruction with the nodes of its operands, and what evaluating it gave
+	struct Node
+	{
+		const compiled::Instruction* instruction;
+		std::vector<std::size_t> operands;
+		token::operand::Ptr value;
+		std::string type;
+		std::string error;
+		std::size_t runs;
+		double nanoseconds;
+	};
+
+	struct Plan
+	{
+		std::vector<Node> nodes;			//	in the order of the instructions, so every node follows its operands
+		std::vector<std::size_t> roots;		//	the nodes left on the stack, the result last
+		std::size_t runs;
+		double evaluation;					//	mean nanoseconds of Expression::evaluate, when analyzed
+		std::string error;					//	of Expression::evaluate, when analyzed
+	};
+
+	const char* nameOf(token::Operator::Type type)
+	{
+		switch (type)
+		{
+			case token::Operator::LeftParanthesis:		return "LeftParanthesis";
+			case token::Operator::RightParanthesis:		return "RightParanthesis";
+			case token::Operator::Power:				return "Power";
+			case token::Operator::Positive:				return "Positive";
+			case token::Operator::Negative:				return "Negative";
+			case token::Operator::Multiplication:		return "Multiplication";
+			case token::Operator::FloatDivision:		return "FloatDivision";
+			case token::Operator::IntegerDivision:		return "IntegerDivision";
+			case token::Operator::Mod:					return "Mod";
+			case token::Operator::Sum:					return "Sum";
+			case token::Operator::Difference:			return "Difference";
+			case token::Operator::LeftBitshift:			return "LeftBitshift";
+			case token::Operator::RightBitshift:		return "RightBitshift";
+			case token::Operator::Equality:				return "Equality";
+			case token::Operator::Inequality:			return "Inequality";
+			case token::Operator::LessThan:				return "LessThan";
+			case token::Operator::LessThanEqual:		return "LessThanEqual";
+			case token::Operator::GreaterThan:			return "GreaterThan";
+			case token::Operator::GreaterThanEqual:		return "GreaterThanEqual";
+			case token::Operator::Not:					return "Not";
+			case token::Operator::And:					return "And";
+			case token::Operator::AndAlso:				return "AndAlso";
+			case token::Operator::Or:					return "Or";
+			case token::Operator::OrElse:				return "OrElse";
+			case token::Operator::Xor:					return "Xor";
+			case token::Operator::Abs:					return "Abs";
+			case token::Operator::Acos:					return "Acos";
+			case token::Operator::Asin:					return "Asin";
+			case token::Operator::Atan:					return "Atan";
+			case token::Operator::Ceil:					return "Ceil";
+			case token::Operator::Cos:					return "Cos";
+			case token::Operator::Exp:					return "Exp";
+			case token::Operator::Floor:				return "Floor";
+			case token::Operator::Log:					return "Log";
+			case token::Operator::Log10:				return "Log10";
+			case token::Operator::Round:				return "Round";
+			case token::Operator::Sin:					return "Sin";
+			case token::Operator::Sqrt:					return "Sqrt";
+			case token::Operator::Tan:					return "Tan";
+			case token::Operator::Truncate:				return "Truncate";
+			case token::Operator::IntegerPower:			return "IntegerPower";
+			default:									return "Unknown";
+		}
+	}
+
+	std::string typeOf(const token::operand::Ptr& value)
+	{
+		if (dynamic_cast<const token::operand::Boolean*>(value.get()))
+			return "Boolean";
+		if (value->isCurrency())
+			return "Currency";
+		return std::holds_alternative<double>(value->getValue()) ? "Float" : "Integer";
+	}
+
+	std::string typeOf(const compiled::Bindings& bindings, std::size_t slot)
+	{
+		return slot < bindings.size() && bindings[slot] ? typeOf(bindings[slot]) : "unbound";
+	}
+
+	//	the tree of the instructions, built with the stack Expression::evaluate uses
+	Plan plan(const compiled::Expression& expression)
+	{
+		Plan result {{}, {}, 0, 0.0, {}};
+
+		for (const auto& instruction : expression.getInstructions())
+		{
+			Node node {&instruction, {}, nullptr, "unknown", {}, 0, 0.0};
+
+			if (instruction.code == compiled::Instruction::Code::Operation) {
+				const auto arity = static_cast<std::size_t>(std::max(instruction.operation.arity, 1));
+				if (result.roots.size() < arity)
+					throw std::runtime_error("Missing operand");
+
+				node.operands.assign(std::end(result.roots) - arity, std::end(result.roots));
+				result.roots.erase(std::end(result.roots) - arity, std::end(result.roots));
+			}
+
+			result.roots.push_back(result.nodes.size());
+			result.nodes.push_back(std::move(node));
+		}
+
+		return result;
+	}
+
+	//	evaluates every node once, operands first, timing the operations when 'timed'
+	void run(Plan& plan, const compiled::Bindings& bindings, bool timed)
+	{
+		for (auto& node : plan.nodes)
+		{
+			const auto& instruction = *node.instruction;
+			node.value = nullptr;
+
+			switch (instruction.code)
+			{
+				case compiled::Instruction::Code::Constant:
+					node.value = instruction.constant;
+					break;
+
+				case compiled::Instruction::Code::Variable:
+					if (instruction.slot < bindings.size() && bindings[instruction.slot])
+						node.value = bindings[instruction.slot];
+					else
+						node.type = "unbound";
+					break;
+
+				case compiled::Instruction::Code::Operation: {
+					if (std::any_of(std::begin(node.operands), std::end(node.operands), [&plan] (std::size_t operand) { return !plan.nodes[operand].value; }))
+						break;
+
+					auto operation = instruction.operation;
+					const auto& first = plan.nodes[node.operands.front()].value;
+					const auto start = timed ? Clock::now() : Clock::time_point();
+
+					try {
+						node.value = node.operands.size() > 1 ? operation.compute(first, plan.nodes[node.operands.back()].value) : operation.compute(first);
+					}
+					catch (const std::exception& e) {
+						node.error = e.what();
+					}
+
+					if (timed)
+						node.nanoseconds += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+					++node.runs;
+					break;
+				}
+			}
+
+			if (node.value) {
+				node.type = typeOf(node.value);
+				if (instruction.code != compiled::Instruction::Code::Operation)
+					++node.runs;
+			}
+		}
+	}
+
+	//	a JSON string, with the control characters JSON doesn't allow raw as \u00XX escapes
+	std::string quoted(std::string_view text)
+	{
+		constexpr char Digits[] = "0123456789abcdef";
+		std::string result = "\"";
+
+		for (const auto ch : text)
+		{
+			if (static_cast<unsigned char>(ch) < 0x20) {
+				result += "\\u00";
+				result += Digits[ch >> 4];
+				result += Digits[ch & 0xf];
+				continue;
+			}
+
+			if (ch == '"' || ch == '\\')
+				result += '\\';
+			result += ch;
+		}
+
+		return result + "\"";
+	}
+
+	void writeText(std::ostream& output, const compiled::Expression& expression, const compiled::Bindings& bindings, const Plan& plan, bool analyzed)
+	{
+		const auto& aliases = expression.getAliases();
+
+		if (analyzed) {
+			output << plan.runs << " runs, evaluate: " << plan.evaluation << " ns per run";
+			if (!plan.error.empty())
+				output << ", error: " << plan.error;
+			output << "\n";
+		}
+
+		output << "slots:";
+		for (auto slot = std::size_t(0); slot < aliases.size(); ++slot)
+			output << (slot ? ", " : " ") << aliases[slot] << " = " << slot << " (" << typeOf(bindings, slot) << ")";
+		output << "\n";
+
+		//	pre-order, with the depth of every node
+		std::vector<std::pair<std::size_t, std::size_t>> pending;
+		for (auto root = plan.roots.rbegin(); root != plan.roots.rend(); ++root)
+			pending.push_back({*root, 0});
+
+		while (!pending.empty())
+		{
+			const auto [index, depth] = pending.back();
+			pending.pop_back();
+
+			const auto& node = plan.nodes[index];
+			const auto& instruction = *node.instruction;
+
+			output << std::string(2 * depth, ' ');
+
+			switch (instruction.code)
+			{
+				case compiled::Instruction::Code::Constant:
+					output << "Constant " << instruction.constant->toString();
+					break;
+
+				case compiled::Instruction::Code::Variable:
+					output << "Variable " << aliases[instruction.slot] << ", slot " << instruction.slot;
+					break;
+
+				case compiled::Instruction::Code::Operation:
+					output << nameOf(instruction.operation.type) << ", precedence " << instruction.operation.precedence;
+					break;
+			}
+
+			output << ": " << node.type;
+
+			if (analyzed) {
+				output << " [" << node.runs << " runs";
+				if (instruction.code == compiled::Instruction::Code::Operation)
+					output << ", " << node.nanoseconds << " ns, " << (node.runs ? node.nanoseconds / node.runs : 0.0) << " ns per run";
+				output << "]";
+			}
+
+			if (!node.error.empty())
+				output << " error: " << node.error;
+			output << "\n";
+
+			for (auto operand = node.operands.rbegin(); operand != node.operands.rend(); ++operand)
+				pending.push_back({*operand, depth + 1});
+		}
+	}
+
+	void writeJson(std::ostream& output, const compiled::Expression& expression, const compiled::Bindings& bindings, const Plan& plan, bool analyzed)
+	{
+		const auto& aliases = expression.getAliases();
+
+		//	every field of the node, up to its operands
+		const auto open = [&] (std::size_t index) {
+			const auto& node = plan.nodes[index];
+			const auto& instruction = *node.instruction;
+
+			switch (instruction.code)
+			{
+				case compiled::Instruction::Code::Constant:
+					output << "{\"node\":\"Constant\",\"value\":" << quoted(instruction.constant->toString());
+					break;
+
+				case compiled::Instruction::Code::Variable:
+					output << "{\"node\":\"Variable\",\"alias\":" << quoted(aliases[instruction.slot]) << ",\"slot\":" << instruction.slot;
+					break;
+
+				case compiled::Instruction::Code::Operation:
+					output << "{\"node\":\"Operation\",\"operator\":" << quoted(nameOf(instruction.operation.type))
+						   << ",\"precedence\":" << instruction.operation.precedence;
+					break;
+			}
+
+			output << ",\"type\":" << quoted(node.type);
+
+			if (analyzed) {
+				output << ",\"runs\":" << node.runs;
+				if (instruction.code == compiled::Instruction::Code::Operation)
+					output << ",\"ns\":" << node.nanoseconds;
+			}
+
+			if (!node.error.empty())
+				output << ",\"error\":" << quoted(node.error);
+
+			if (instruction.code == compiled::Instruction::Code::Operation)
+				output << ",\"operands\":[";
+		};
+
+		output << "{";
+
+		if (analyzed) {
+			output << "\"runs\":" << plan.runs << ",\"evaluate_ns\":" << plan.evaluation << ",";
+			if (!plan.error.empty())
+				output << "\"error\":" << quoted(plan.error) << ",";
+		}
+
+		output << "\"slots\":[";
+		for (auto slot = std::size_t(0); slot < aliases.size(); ++slot)
+			output << (slot ? "," : "") << "{\"alias\":" << quoted(aliases[slot]) << ",\"slot\":" << slot << ",\"type\":" << quoted(typeOf(bindings, slot)) << "}";
+		output << "],\"plan\":[";
+
+		//	the node and the next of its operands to write
+		std::vector<std::pair<std::size_t, std::size_t>> pending;
+
+		for (auto root = std::size_t(0); root < plan.roots.size(); ++root)
+		{
+			output << (root ? "," : "");
+			open(plan.roots[root]);
+			pending.push_back({plan.roots[root], 0});
+
+			while (!pending.empty())
+			{
+				const auto index = pending.back().first;
+				const auto& operands = plan.nodes[index].operands;
+
+				if (pending.back().second < operands.size()) {
+					const auto operand = pending.back().second++;
+					output << (operand ? "," : "");
+					open(operands[operand]);
+					pending.push_back({operands[operand], 0});
+					continue;
+				}
+
+				output << (plan.nodes[index].instruction->code == compiled::Instruction::Code::Operation ? "]}" : "}");
+				pending.pop_back();
+			}
+		}
+
+		output << "]}\n";
+	}
+
+	std::string write(const compiled::Expression& expression, const compiled::Bindings& bindings, const Plan& plan, bool analyzed, compiled::PlanFormat format)
+	{
+		std::ostringstream output;
+		output << std::fixed << std::setprecision(1);
+
+		if (format == compiled::PlanFormat::Json)
+			writeJson(output, expression, bindings, plan, analyzed);
+		else
+			writeText(output, expression, bindings, plan, analyzed);
+
+		return output.str();
+	}
+}
+
+std::string compiled::explain(const Expression& expression, const Bindings& bindings, PlanFormat format)
+{
+	auto explained = plan(expression);
+	run(explained, bindings, false);
+
+	return write(expression, bindings, explained, false, format);
+}
+
+std::string compiled::analyze(const Expression& expression, const Bindings& bindings, std::size_t runs, PlanFormat format)
+{
+	auto analyzed = plan(expression);
+	analyzed.runs = runs;
+
+	for (auto i = std::size_t(0); i < runs; ++i)
+		run(analyzed, bindings, true);
+
+	//	an evaluation that fails fails the same way every time, so the time is that of the first
+	const auto start = Clock::now();
+	auto evaluated = std::size_t(0);
+
+	try {
+		while (evaluated < runs)
+		{
+			++evaluated;
+			expression.evaluate(bindings);
+		}
+	}
+	catch (const std::exception& e) {
+		analyzed.error = e.what();
+	}
+
+	if (evaluated > 0)
+		analyzed.evaluation = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / evaluated;
+
+	return write(expression, bindings, analyzed, true, format);
+}
@@ -0,0 +1,27 @@
+#ifndef EXPLAIN_H
+#define EXPLAIN_H
+
+#include "Expression.h"
+
+#include <cstddef>
+#include <string>
+
+namespace compiled
+{
+	enum class PlanFormat { Text, Json };
+
+	//	the expression as it was parsed: the tree of its operations with their types and precedences, the slot every
+	//	variable resolved to, and the type of every value when evaluated against the bindings ("unbound" for a variable
+	//	without a binding and "unknown" for what depends on it or on an operation that failed)
+	//
+	//	the text form is one node per line, indented under the operation that takes it; the JSON form is an object
+	//	with the "slots" and the "plan", a list of trees (one per operand left on the stack, the last being the result)
+	std::string explain(const Expression& expression, const Bindings& bindings, PlanFormat format = PlanFormat::Text);
+
+	//	the plan, evaluated 'runs' times node by node, with every node annotated with how many times it ran and the time
+	//	its operation took, operands excluded, along with the mean time of Expression::evaluate for comparison; timing
+	//	every node adds tens of nanoseconds to each, which the node times include
+	std::string analyze(const Expression& expression, const Bindings& bindings, std::size_t runs, PlanFormat format = PlanFormat::Text);
+}
+
+#endif
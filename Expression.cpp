@@ -0,0 +1,669 @@
+#include "Expression.h"
+
+#include "Utils.h"
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Integer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stack>
+#include <stdexcept>
+
+namespace
+{
+	void emitOperation(std::stack<token::Operator>& operators, std::vector<compiled::Instruction>& instructions)
+	{
+		if (operators.top().type == token::Operator::Type::LeftParanthesis)
+			throw std::runtime_error("Mismatched parentheses");
+
+		instructions.push_back({compiled::Instruction::Code::Operation, nullptr, 0, operators.top()});
+		operators.pop();
+	}
+
+	//	the sums, differences, products, quotients and comparisons of operands that aren't Currency, with the expressions
+	//	Operator::compute uses, so the results are the same, but allocated in one block with their reference count;
+	//	nothing for any other operation
+	token::operand::Ptr computeInline(token::Operator::Type type, const token::operand::Ptr& leftOperand, const token::operand::Ptr& rightOperand)
+	{
+		if (leftOperand->isCurrency() || rightOperand->isCurrency())
+			return nullptr;
+
+		return std::visit([type] (auto left, auto right) -> token::operand::Ptr {
+			const auto number = [] (auto value) -> token::operand::Ptr {
+				if constexpr (std::is_same_v<decltype(value), double>)
+					return std::make_shared<token::operand::Float>(value);
+				else
+					return std::make_shared<token::operand::Integer>(value);
+			};
+
+			const auto boolean = [] (bool value) { return std::make_shared<token::operand::Boolean>(value); };
+
+			switch (type)
+			{
+				case token::Operator::Sum:					return number(left + right);
+				case token::Operator::Difference:			return number(left - right);
+				case token::Operator::Multiplication:		return number(left * right);
+				case token::Operator::FloatDivision:		return std::make_shared<token::operand::Float>(1.0 * left / right);
+				case token::Operator::Equality:				return boolean(left == right);
+				case token::Operator::Inequality:			return boolean(left != right);
+				case token::Operator::LessThan:				return boolean(left < right);
+				case token::Operator::LessThanEqual:		return boolean(left <= right);
+				case token::Operator::GreaterThan:			return boolean(left > right);
+				case token::Operator::GreaterThanEqual:		return boolean(left >= right);
+				default:									return nullptr;
+			}
+		}, leftOperand->getValue(), rightOperand->getValue());
+	}
+
+	token::operand::Ptr computeFused(token::Operator operation, const token::operand::Ptr& leftOperand, const token::operand::Ptr& rightOperand)
+	{
+		if (auto result = computeInline(operation.type, leftOperand, rightOperand))
+			return result;
+		return operation.compute(leftOperand, rightOperand);
+	}
+
+	//	the budget of an evaluation without limits
+	struct Unmetered
+	{
+		void spend()
+		{ }
+	};
+
+	//	rewrites operations whose right operand is a constant into cheaper ones with the same results, bit for bit:
+	//	Power with a small integer exponent into IntegerPower, and division by a power of two into multiplication
+	void reduceStrength(std::vector<compiled::Instruction>& instructions)
+	{
+		for (auto i = std::size_t(1); i < instructions.size(); ++i)
+		{
+			auto& operation = instructions[i].operation;
+			auto& operand = instructions[i - 1];
+
+			if (instructions[i].code != compiled::Instruction::Code::Operation || operand.code != compiled::Instruction::Code::Constant)
+				continue;
+
+			const auto value = std::visit([] (auto&& val) { return static_cast<double>(val); }, operand.constant->getValue());
+			auto exponent = 0;
+
+			if (operation.type == token::Operator::Power && value == std::trunc(value) && std::abs(value) <= 64) {
+				operand.constant = std::make_shared<token::operand::Integer>(static_cast<long long>(value));
+				operation.type = token::Operator::IntegerPower;
+			}
+			else if (operation.type == token::Operator::FloatDivision && std::abs(std::frexp(value, &exponent)) == 0.5 && std::abs(exponent) <= 1000) {
+				operand.constant = std::make_shared<token::operand::Float>(1.0 / value);
+				operation.type = token::Operator::Multiplication;
+			}
+		}
+	}
+}
+
+//	the functions defined in the preamble, each compiled on its first call
+struct compiled::Expression::Functions
+{
+	struct Function
+	{
+		std::string_view name;
+		std::vector<std::string_view> parameters;
+		std::string_view body;
+		std::optional<Expression> compiled;
+		bool compiling;
+	};
+
+	Function* find(std::string_view name)
+	{
+		const auto found = std::find_if(std::begin(definitions), std::end(definitions), [name] (const Function& function) { return function.name == name; });
+		return found == std::end(definitions) ? nullptr : &*found;
+	}
+
+	std::vector<Function> definitions;
+	Budget* budget = nullptr;
+	bool optimize = true;
+};
+
+compiled::Expression compiled::Expression::compile(std::string_view expression)
+{
+	Functions functions;
+	return compile(expression, functions);
+}
+
+compiled::Expression compiled::Expression::compile(std::string_view expression, Budget& budget)
+{
+	budget.checkLength(expression.size());
+
+	Functions functions;
+	functions.budget = &budget;
+	return compile(expression, functions);
+}
+
+compiled::Expression compiled::Expression::compileBaseline(std::string_view expression)
+{
+	Functions functions;
+	functions.optimize = false;
+	return compile(expression, functions);
+}
+
+compiled::Expression compiled::Expression::compile(std::string_view expression, Functions& functions)
+{
+	const auto expressionStart = expression.find(';');
+
+	//	a preamble without parentheses has no function to look for
+	if (expressionStart != std::string::npos && expression.substr(0, expressionStart).find('(') != std::string_view::npos)
+		for (auto& var : parseVariables(expression))
+			if (!var.body.empty() && !functions.find(var.alias))
+				functions.definitions.push_back({var.alias, std::move(var.parameters), var.body, {}, false});
+
+	if (expressionStart != std::string::npos)
+		expression.remove_prefix(expressionStart + 1);
+
+	auto result = compile(expression, functions, 0);
+
+	//	unfused, a single step stands for every instruction
+	if (functions.optimize)
+		result.fuse();
+	else
+		result.steps = {{Step::Code::Instruction, 0, result.instructions.size(), 0, 0, nullptr, {}}};
+
+	return result;
+}
+
+compiled::Expression compiled::Expression::compile(const SyntaxTree& tree)
+{
+	Expression result;
+	result.aliases = tree.getAliases();
+	result.instructions.reserve(tree.getNodes().size());
+
+	for (const auto& node : tree.getNodes())
+	{
+		switch (node.kind)
+		{
+			case SyntaxTree::Node::Kind::Constant:
+				result.instructions.push_back({Instruction::Code::Constant, tree.getConstants()[node.value], 0, {}});
+				break;
+
+			case SyntaxTree::Node::Kind::Variable:
+				result.instructions.push_back({Instruction::Code::Variable, nullptr, node.value, {}});
+				break;
+
+			case SyntaxTree::Node::Kind::Operation:
+				result.instructions.push_back({Instruction::Code::Operation, nullptr, 0, node.operation});
+				break;
+		}
+	}
+
+	reduceStrength(result.instructions);
+	result.fuse();
+	return result;
+}
+
+compiled::Expression compiled::Expression::compile(std::string_view expression, Functions& functions, std::size_t depth)
+{
+	if (depth > MaxInlineDepth)
+		throw std::runtime_error("Functions nested more than " + std::to_string(MaxInlineDepth) + " levels deep");
+
+	Expression result;
+	std::stack<token::Operator> operators;
+	Context context;
+	auto tokens = std::size_t(0);
+
+	expression = utils::str::skipWhitespace(expression);
+
+	for (std::optional<std::string_view> parsed; !expression.empty(); expression = parsed.value())
+	{
+		if (functions.budget && ++tokens % Budget::CheckInterval == 0)
+			functions.budget->checkTime();
+
+		if (token::Operator currentOperator; (parsed = currentOperator.parse(expression, context))) {
+			if (functions.budget && context.parenthesesOpen > 0)
+				functions.budget->checkDepth(static_cast<std::size_t>(context.parenthesesOpen));
+
+			if (currentOperator.type == token::Operator::Type::RightParanthesis) {
+				while (!operators.empty() && operators.top().type != token::Operator::Type::LeftParanthesis)
+					emitOperation(operators, result.instructions);
+
+				if (operators.empty())
+					throw std::runtime_error("Mismatched parentheses");
+
+				operators.pop();
+			}
+			else {
+				while (currentOperator.arity > 1
+					   && !operators.empty()
+					   && currentOperator.precedence >= operators.top().precedence
+					   && operators.top().type != token::Operator::Type::LeftParanthesis)
+				{
+					emitOperation(operators, result.instructions);
+				}
+
+				operators.push(currentOperator);
+			}
+
+			continue;
+		}
+
+		if (token::operand::Boolean currentBool; (parsed = currentBool.parse(expression, context))) {
+			result.instructions.push_back({Instruction::Code::Constant, std::make_shared<token::operand::Boolean>(currentBool), 0, {}});
+			continue;
+		}
+
+		if (token::operand::Currency currentCurrency; (parsed = currentCurrency.parse(expression, context))) {
+			result.instructions.push_back({Instruction::Code::Constant, std::make_shared<token::operand::Currency>(currentCurrency), 0, {}});
+			continue;
+		}
+
+		if (token::operand::Float currentFloat; (parsed = currentFloat.parse(expression, context))) {
+			result.instructions.push_back({Instruction::Code::Constant, std::make_shared<token::operand::Float>(currentFloat), 0, {}});
+			continue;
+		}
+
+		if (token::operand::Integer currentInt; (parsed = currentInt.parse(expression, context))) {
+			result.instructions.push_back({Instruction::Code::Constant, std::make_shared<token::operand::Integer>(currentInt), 0, {}});
+			continue;
+		}
+
+		if (token::Variable currentVariable; (parsed = currentVariable.parseAlias(expression, context))) {
+			if (!parsed->empty() && parsed->front() == '(') {
+				if (const auto rest = result.inlineCall(currentVariable.alias, parsed->substr(1), functions, depth)) {
+					parsed = rest;
+					continue;
+				}
+			}
+
+			result.instructions.push_back({Instruction::Code::Variable, nullptr, result.addSlot(currentVariable.alias), {}});
+			continue;
+		}
+	}
+
+	while (!operators.empty())
+		emitOperation(operators, result.instructions);
+
+	if (functions.optimize)
+		reduceStrength(result.instructions);
+	return result;
+}
+
+token::operand::Ptr compiled::Expression::evaluate(const Bindings& bindings) const
+{
+	Unmetered meter;
+	return run(bindings, meter);
+}
+
+token::operand::Ptr compiled::Expression::evaluate(const Bindings& bindings, Budget& budget) const
+{
+	return run(bindings, budget);
+}
+
+template <typename Meter>
+token::operand::Ptr compiled::Expression::run(const Bindings& bindings, Meter& meter) const
+{
+	std::vector<token::operand::Ptr> operands;
+	operands.reserve(instructions.size());
+
+	const auto bound = [&bindings] (std::size_t slot) {
+		return slot < bindings.size() && bindings[slot] ? &bindings[slot] : nullptr;
+	};
+
+	for (const auto& step : steps)
+	{
+		switch (step.code)
+		{
+			case Step::Code::VariableConstantOperation:
+				if (const auto variable = bound(step.slot)) {
+					meter.spend();
+					operands.push_back(computeFused(step.operation, *variable, step.constant));
+					continue;
+				}
+				break;
+
+			case Step::Code::VariableVariableOperation:
+				if (const auto left = bound(step.slot), right = bound(step.otherSlot); left && right) {
+					meter.spend();
+					operands.push_back(computeFused(step.operation, *left, *right));
+					continue;
+				}
+				break;
+
+			case Step::Code::ConstantOperation:
+				if (!operands.empty()) {
+					meter.spend();
+					operands.back() = computeFused(step.operation, operands.back(), step.constant);
+					continue;
+				}
+				break;
+
+			case Step::Code::VariableFunction:
+				if (const auto variable = bound(step.slot)) {
+					auto operation = step.operation;
+					meter.spend();
+					operands.push_back(operation.compute(*variable));
+					continue;
+				}
+				break;
+
+			case Step::Code::Instruction:
+				break;
+		}
+
+		//	a single instruction, or a sequence whose variable isn't bound (and is skipped) or that lacks an operand
+		for (auto i = step.first; i < step.first + step.count; ++i)
+		{
+			const auto& instruction = instructions[i];
+
+			switch (instruction.code)
+			{
+				case Instruction::Code::Constant:
+					operands.push_back(instruction.constant);
+					break;
+
+				case Instruction::Code::Variable:
+					if (const auto variable = bound(instruction.slot))
+						operands.push_back(*variable);
+					break;
+
+				case Instruction::Code::Operation:
+					meter.spend();
+					apply(instruction.operation, operands);
+					break;
+			}
+		}
+	}
+
+	if (operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	return operands.back();
+}
+
+compiled::Bindings compiled::Expression::bind(const std::vector<token::Variable>& vars) const
+{
+	Bindings bindings(aliases.size());
+
+	for (auto slot = 0u; slot < aliases.size(); ++slot)
+	{
+		const auto found = std::find_if(std::begin(vars), std::end(vars),
+										[this, slot] (const token::Variable& var) { return aliases[slot] == var.alias; });
+
+		if (found != std::end(vars))
+			bindings[slot] = found->operand;
+	}
+
+	return bindings;
+}
+
+compiled::Expression compiled::Expression::specialize(const Bindings& fixed) const
+{
+	//	a folded value, or the instructions of a subtree that still needs a free variable
+	struct Fragment
+	{
+		token::operand::Ptr value;
+		std::vector<Instruction> instructions;
+	};
+
+	const auto isFolded = [] (const Fragment& fragment) { return fragment.value != nullptr; };
+	const auto constant = [] (token::operand::Ptr value) { return Instruction {Instruction::Code::Constant, std::move(value), 0, {}}; };
+
+	std::vector<Fragment> fragments;
+
+	for (const auto& instruction : instructions)
+	{
+		switch (instruction.code)
+		{
+			case Instruction::Code::Constant:
+				fragments.push_back({instruction.constant, {}});
+				break;
+
+			case Instruction::Code::Variable:
+				if (instruction.slot < fixed.size() && fixed[instruction.slot])
+					fragments.push_back({fixed[instruction.slot], {}});
+				else
+					fragments.push_back({nullptr, {instruction}});
+				break;
+
+			case Instruction::Code::Operation: {
+				const auto arity = static_cast<std::size_t>(std::max(instruction.operation.arity, 1));
+				if (fragments.size() < arity)
+					throw std::runtime_error("Missing operand");
+
+				const auto first = std::end(fragments) - arity;
+				Fragment merged;
+
+				if (std::all_of(first, std::end(fragments), isFolded)) {
+					std::vector<token::operand::Ptr> operands;
+					for (auto fragment = first; fragment != std::end(fragments); ++fragment)
+						operands.push_back(fragment->value);
+
+					apply(instruction.operation, operands);
+					merged.value = operands.back();
+				}
+				else {
+					for (auto fragment = first; fragment != std::end(fragments); ++fragment) {
+						if (isFolded(*fragment))
+							merged.instructions.push_back(constant(fragment->value));
+						else if (merged.instructions.empty())
+							merged.instructions = std::move(fragment->instructions);
+						else
+							merged.instructions.insert(std::end(merged.instructions), std::begin(fragment->instructions), std::end(fragment->instructions));
+					}
+
+					merged.instructions.push_back(instruction);
+				}
+
+				fragments.erase(first, std::end(fragments));
+				fragments.push_back(std::move(merged));
+				break;
+			}
+		}
+	}
+
+	Expression residual;
+	residual.aliases = aliases;
+
+	for (auto& fragment : fragments)
+	{
+		if (isFolded(fragment))
+			residual.instructions.push_back(constant(fragment.value));
+		else
+			residual.instructions.insert(std::end(residual.instructions), std::begin(fragment.instructions), std::end(fragment.instructions));
+	}
+
+	residual.fuse();
+	return residual;
+}
+
+//	folding first, so that an exponent or a divisor folded into a constant is strength reduced too
+compiled::Expression compiled::Expression::optimize() const
+{
+	auto optimized = specialize({});
+	reduceStrength(optimized.instructions);
+	optimized.fuse();
+	return optimized;
+}
+
+std::optional<std::size_t> compiled::Expression::slotOf(std::string_view alias) const
+{
+	const auto found = std::find(std::begin(aliases), std::end(aliases), alias);
+	if (found == std::end(aliases)) return {};
+
+	return static_cast<std::size_t>(std::distance(std::begin(aliases), found));
+}
+
+const std::vector<std::string>& compiled::Expression::getAliases() const
+{
+	return aliases;
+}
+
+const std::vector<compiled::Instruction>& compiled::Expression::getInstructions() const
+{
+	return instructions;
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> compiled::Expression::getSuperinstructions() const
+{
+	std::vector<std::pair<std::size_t, std::size_t>> superinstructions;
+
+	for (const auto& step : steps)
+		if (step.code != Step::Code::Instruction)
+			superinstructions.emplace_back(step.first, step.count);
+
+	return superinstructions;
+}
+
+//	a call is replaced by the body of the function, with the program of each argument in place of its parameter,
+//	which is what compiling the call textually expanded to '((argument) ... (argument))' would give
+std::optional<std::string_view> compiled::Expression::inlineCall(std::string_view name, std::string_view arguments, Functions& functions, std::size_t depth)
+{
+	const auto function = functions.find(name);
+	if (!function) return {};
+
+	std::vector<std::string_view> values;
+	auto callEnd = std::string_view::npos;
+
+	for (auto i = std::size_t(0), start = std::size_t(0), nesting = std::size_t(0); i < arguments.size() && callEnd == std::string_view::npos; ++i)
+	{
+		if (arguments[i] == '(')
+			++nesting;
+		else if (arguments[i] == ')' && nesting > 0)
+			--nesting;
+		else if ((arguments[i] == ')' || arguments[i] == ',') && nesting == 0) {
+			values.push_back(arguments.substr(start, i - start));
+			start = i + 1;
+
+			if (arguments[i] == ')')
+				callEnd = i;
+		}
+	}
+
+	if (callEnd == std::string_view::npos)
+		throw std::runtime_error("Mismatched parentheses");
+
+	if (values.size() == 1 && utils::str::skipWhitespace(values.front()).empty())
+		values.clear();
+
+	const auto& parameters = function->parameters;
+	const auto functionName = std::string(name);
+
+	if (values.size() != parameters.size())
+		throw std::runtime_error("Function '" + functionName + "' takes " + std::to_string(parameters.size()) + " argument(s)");
+
+	if (!function->compiled) {
+		if (function->compiling)
+			throw std::runtime_error("Function '" + functionName + "' calls itself");
+
+		function->compiling = true;
+		function->compiled = compile(function->body, functions, depth + 1);
+		function->compiling = false;
+	}
+
+	std::vector<Expression> programs;
+	for (const auto value : values)
+		programs.push_back(compile(value, functions, depth));
+
+	const auto& body = function->compiled.value();
+
+	for (const auto& instruction : body.instructions)
+	{
+		if (instruction.code != Instruction::Code::Variable) {
+			instructions.push_back(instruction);
+			continue;
+		}
+
+		const auto& alias = body.aliases[instruction.slot];
+
+		if (const auto parameter = std::find(std::begin(parameters), std::end(parameters), alias); parameter != std::end(parameters))
+			append(programs[std::distance(std::begin(parameters), parameter)]);
+		else
+			instructions.push_back({Instruction::Code::Variable, nullptr, addSlot(alias), {}});
+
+		if (instructions.size() > MaxInlinedInstructions)
+			throw std::runtime_error("Function '" + functionName + "' expands to more than " + std::to_string(MaxInlinedInstructions) + " instructions");
+	}
+
+	return utils::str::skipWhitespace(arguments.substr(callEnd + 1));
+}
+
+void compiled::Expression::append(const Expression& fragment)
+{
+	for (const auto& instruction : fragment.instructions)
+	{
+		if (instruction.code == Instruction::Code::Variable)
+			instructions.push_back({Instruction::Code::Variable, nullptr, addSlot(fragment.aliases[instruction.slot]), {}});
+		else
+			instructions.push_back(instruction);
+	}
+}
+
+//	the sequences fused are the most frequent in the instruction pair profile of the fusion benchmark
+void compiled::Expression::fuse()
+{
+	const auto isVariable = [this] (std::size_t i) { return i < instructions.size() && instructions[i].code == Instruction::Code::Variable; };
+	const auto isConstant = [this] (std::size_t i) { return i < instructions.size() && instructions[i].code == Instruction::Code::Constant; };
+	const auto isOperation = [this] (std::size_t i, bool binary) {
+		return i < instructions.size() && instructions[i].code == Instruction::Code::Operation && (instructions[i].operation.arity > 1) == binary;
+	};
+
+	steps.clear();
+
+	for (auto i = std::size_t(0); i < instructions.size(); )
+	{
+		const auto& instruction = instructions[i];
+		Step step {Step::Code::Instruction, i, 1, 0, 0, nullptr, {}};
+
+		if (isVariable(i) && isConstant(i + 1) && isOperation(i + 2, true))
+			step = {Step::Code::VariableConstantOperation, i, 3, instruction.slot, 0, instructions[i + 1].constant, instructions[i + 2].operation};
+		else if (isVariable(i) && isVariable(i + 1) && isOperation(i + 2, true))
+			step = {Step::Code::VariableVariableOperation, i, 3, instruction.slot, instructions[i + 1].slot, nullptr, instructions[i + 2].operation};
+		else if (isConstant(i) && isOperation(i + 1, true))
+			step = {Step::Code::ConstantOperation, i, 2, 0, 0, instruction.constant, instructions[i + 1].operation};
+		else if (isVariable(i) && isOperation(i + 1, false))
+			step = {Step::Code::VariableFunction, i, 2, instruction.slot, 0, nullptr, instructions[i + 1].operation};
+
+		i += step.count;
+		steps.push_back(std::move(step));
+	}
+}
+
+std::size_t compiled::Expression::addSlot(std::string_view alias)
+{
+	if (const auto slot = slotOf(alias))
+		return slot.value();
+
+	aliases.emplace_back(alias);
+	return aliases.size() - 1;
+}
+
+void compiled::apply(token::Operator operation, std::vector<token::operand::Ptr>& operands)
+{
+	if (operands.size() < static_cast<std::size_t>(std::max(operation.arity, 1)))
+		throw std::runtime_error("Missing operand");
+
+	auto currentOperand = std::move(operands.back());
+	operands.pop_back();
+
+	if (operation.arity <= 1)
+		operands.push_back(operation.compute(std::move(currentOperand)));
+	else {
+		auto prevOperand = std::move(operands.back());
+		operands.pop_back();
+		operands.push_back(operation.compute(std::move(prevOperand), std::move(currentOperand)));
+	}
+}
+
+std::vector<token::Variable> compiled::parseVariables(std::string_view expression)
+{
+	expression = utils::str::skipWhitespace(expression);
+
+	std::vector<token::Variable> vars;
+
+	//	'parsed' is read after each push, so it lives in the body rather than in the condition, which GCC ends first
+	for (token::Variable variable; ; )
+	{
+		const auto parsed = variable.parse(expression);
+		if (!parsed)
+			break;
+
+		vars.push_back(variable);
+		expression = parsed.value();
+	}
+
+	return vars;
+}
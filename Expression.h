@@ -0,0 +1,127 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "Budget.h"
+#include "Operand.h"
+#include "Operator.h"
+#include "SyntaxTree.h"
+#include "Variable.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace compiled
+{
+	//	a single step of a compiled statement, stored in postfix order
+	struct Instruction
+	{
+		enum class Code { Constant, Variable, Operation };
+
+		Code code;
+		token::operand::Ptr constant;
+		std::size_t slot;
+		token::Operator operation;
+	};
+
+	//	operands bound to the variable slots of an expression, indexed by slot
+	//	an empty pointer marks an unbound variable, which is skipped when evaluating
+	using Bindings = std::vector<token::operand::Ptr>;
+
+	class Expression
+	{
+		public:
+			//	compiles the statement after the ';' of the expression (or the whole expression if there is none)
+			//	calls to the functions defined in the preamble are inlined, up to MaxInlineDepth nested definitions
+			static Expression compile(std::string_view expression);
+
+			//	within the length, depth and time of the budget
+			static Expression compile(std::string_view expression, Budget& budget);
+
+			//	the program of a parsed statement, the same Expression::compile gives for its text
+			static Expression compile(const SyntaxTree& tree);
+
+			//	without strength reduction or superinstructions, for an expression that only runs a few times
+			static Expression compileBaseline(std::string_view expression);
+
+			token::operand::Ptr evaluate(const Bindings& bindings) const;
+
+			//	within the operations and time of the budget
+			token::operand::Ptr evaluate(const Bindings& bindings, Budget& budget) const;
+
+			//	resolves every slot against the variables parsed from a preamble
+			Bindings bind(const std::vector<token::Variable>& vars) const;
+
+			//	folds every subtree that depends only on the bound slots of 'fixed' (and on constants)
+			//	the residual keeps the same slots and gives the same results for any binding of the remaining ones
+			Expression specialize(const Bindings& fixed) const;
+
+			//	with every constant subtree folded, then strength reduced and fused, for an expression that runs often
+			Expression optimize() const;
+
+			std::optional<std::size_t> slotOf(std::string_view alias) const;
+
+			const std::vector<std::string>& getAliases() const;
+			const std::vector<Instruction>& getInstructions() const;
+
+			//	the instructions evaluate runs as superinstructions: the first of each and how many it stands for
+			std::vector<std::pair<std::size_t, std::size_t>> getSuperinstructions() const;
+
+			static constexpr std::size_t MaxInlineDepth = 16;
+			static constexpr std::size_t MaxInlinedInstructions = 1 << 20;
+
+		private:
+			struct Functions;
+
+			//	what evaluate runs: a single instruction, or one of the sequences most common in formulas fused into a
+			//	superinstruction with its operands inline, which evaluates them without the stack in between
+			struct Step
+			{
+				enum class Code
+				{
+					Instruction,
+					VariableConstantOperation,		//	x * 2
+					VariableVariableOperation,		//	x + y
+					ConstantOperation,				//	... > 3, on the operand at the top of the stack
+					VariableFunction				//	Sqrt(x)
+				};
+
+				Code code;
+				std::size_t first, count;			//	the instructions it stands for
+				std::size_t slot, otherSlot;
+				token::operand::Ptr constant;
+				token::Operator operation;
+			};
+
+			void fuse();
+
+			static Expression compile(std::string_view expression, Functions& functions);
+			static Expression compile(std::string_view statement, Functions& functions, std::size_t depth);
+
+			//	evaluates the steps, counting every operation on the meter
+			template <typename Meter>
+			token::operand::Ptr run(const Bindings& bindings, Meter& meter) const;
+
+			//	inlines the call to 'name' whose arguments follow, returning the rest of the statement after the call
+			//	or nothing if 'name' isn't a function
+			std::optional<std::string_view> inlineCall(std::string_view name, std::string_view arguments, Functions& functions, std::size_t depth);
+			void append(const Expression& fragment);
+
+			std::size_t addSlot(std::string_view alias);
+
+			std::vector<Instruction> instructions;
+			std::vector<Step> steps;
+			std::vector<std::string> aliases;
+	};
+
+	//	pops the operands of the operation off the stack and pushes its result
+	void apply(token::Operator operation, std::vector<token::operand::Ptr>& operands);
+
+	//	parses the 'alias = value' preamble at the start of the expression
+	std::vector<token::Variable> parseVariables(std::string_view expression);
+}
+
+#endif
@@ -0,0 +1,626 @@
+#include "Filter.h"
+
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Integer.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FILTER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FILTER_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t BlockRows = 64;
+	constexpr auto None = ~std::size_t(0);
+	constexpr auto Infinity = std::numeric_limits<double>::infinity();
+
+	unsigned firstSet(std::uint64_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return index;
+#else
+		return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+	}
+
+	bool isComparison(token::Operator::Type type)
+	{
+		return type >= token::Operator::Equality && type <= token::Operator::GreaterThanEqual;
+	}
+
+	//	the comparison that gives the same result with its operands swapped
+	token::Operator::Type mirrored(token::Operator::Type comparison)
+	{
+		switch (comparison)
+		{
+			case token::Operator::LessThan:				return token::Operator::GreaterThan;
+			case token::Operator::LessThanEqual:		return token::Operator::GreaterThanEqual;
+			case token::Operator::GreaterThan:			return token::Operator::LessThan;
+			case token::Operator::GreaterThanEqual:		return token::Operator::LessThanEqual;
+			default:									return comparison;
+		}
+	}
+
+	//	as Operator::compute compares, with an integer and a float compared as floats
+	template <token::Operator::Type Comparison, typename Left, typename Right>
+	bool holds(Left left, Right right)
+	{
+		if constexpr (Comparison == token::Operator::Equality)
+			return left == right;
+		else if constexpr (Comparison == token::Operator::Inequality)
+			return left != right;
+		else if constexpr (Comparison == token::Operator::LessThan)
+			return left < right;
+		else if constexpr (Comparison == token::Operator::LessThanEqual)
+			return left <= right;
+		else if constexpr (Comparison == token::Operator::GreaterThan)
+			return left > right;
+		else
+			return left >= right;
+	}
+
+#ifdef FILTER_AVX2
+	//	the ordered predicates are false on NaN, as the comparisons of doubles are, and '<>' is true on it
+	template <token::Operator::Type Comparison>
+	constexpr int floatPredicate()
+	{
+		switch (Comparison)
+		{
+			case token::Operator::Equality:			return _CMP_EQ_OQ;
+			case token::Operator::Inequality:		return _CMP_NEQ_UQ;
+			case token::Operator::LessThan:			return _CMP_LT_OQ;
+			case token::Operator::LessThanEqual:	return _CMP_LE_OQ;
+			case token::Operator::GreaterThan:		return _CMP_GT_OQ;
+			default:								return _CMP_GE_OQ;
+		}
+	}
+
+	template <token::Operator::Type Comparison>
+	__m256i compareIntegers(__m256i left, __m256i right)
+	{
+		const auto ones = _mm256_set1_epi64x(-1);
+
+		if constexpr (Comparison == token::Operator::Equality)
+			return _mm256_cmpeq_epi64(left, right);
+		else if constexpr (Comparison == token::Operator::Inequality)
+			return _mm256_xor_si256(_mm256_cmpeq_epi64(left, right), ones);
+		else if constexpr (Comparison == token::Operator::LessThan)
+			return _mm256_cmpgt_epi64(right, left);
+		else if constexpr (Comparison == token::Operator::LessThanEqual)
+			return _mm256_xor_si256(_mm256_cmpgt_epi64(left, right), ones);
+		else if constexpr (Comparison == token::Operator::GreaterThan)
+			return _mm256_cmpgt_epi64(left, right);
+		else
+			return _mm256_xor_si256(_mm256_cmpgt_epi64(right, left), ones);
+	}
+#endif
+
+#ifdef FILTER_SSE2
+	template <token::Operator::Type Comparison>
+	__m128d compareFloats(__m128d left, __m128d right)
+	{
+		if constexpr (Comparison == token::Operator::Equality)
+			return _mm_cmpeq_pd(left, right);
+		else if constexpr (Comparison == token::Operator::Inequality)
+			return _mm_cmpneq_pd(left, right);
+		else if constexpr (Comparison == token::Operator::LessThan)
+			return _mm_cmplt_pd(left, right);
+		else if constexpr (Comparison == token::Operator::LessThanEqual)
+			return _mm_cmple_pd(left, right);
+		else if constexpr (Comparison == token::Operator::GreaterThan)
+			return _mm_cmpgt_pd(left, right);
+		else
+			return _mm_cmpge_pd(left, right);
+	}
+#endif
+
+	//	bit i set when 'left[i]' and 'right[i * step]' compare true, for the first 'count' (at most 64) rows
+	//	doubles are compared 4 or 2 at a time and integers 4 at a time when AVX2 or SSE2 is available
+	template <token::Operator::Type Comparison, typename Left, typename Right>
+	std::uint64_t compareRun(const Left* left, const Right* right, std::size_t step, std::size_t count)
+	{
+		auto bits = std::uint64_t(0);
+		auto i = std::size_t(0);
+
+#ifdef FILTER_AVX2
+		if constexpr (std::is_same_v<Left, double> && std::is_same_v<Right, double>) {
+			constexpr auto predicate = floatPredicate<Comparison>();
+
+			for (; i + 4 <= count; i += 4) {
+				const auto rhs = step ? _mm256_loadu_pd(right + i) : _mm256_set1_pd(*right);
+				bits |= std::uint64_t(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(left + i), rhs, predicate))) << i;
+			}
+		}
+		else if constexpr (std::is_same_v<Left, long long> && std::is_same_v<Right, long long>) {
+			for (; i + 4 <= count; i += 4) {
+				const auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+				const auto rhs = step ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i)) : _mm256_set1_epi64x(*right);
+				bits |= std::uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(compareIntegers<Comparison>(lhs, rhs)))) << i;
+			}
+		}
+#endif
+
+#ifdef FILTER_SSE2
+		if constexpr (std::is_same_v<Left, double> && std::is_same_v<Right, double>) {
+			for (; i + 2 <= count; i += 2) {
+				const auto rhs = step ? _mm_loadu_pd(right + i) : _mm_set1_pd(*right);
+				bits |= std::uint64_t(_mm_movemask_pd(compareFloats<Comparison>(_mm_loadu_pd(left + i), rhs))) << i;
+			}
+		}
+#endif
+
+		for (; i < count; ++i)
+			bits |= std::uint64_t(holds<Comparison>(left[i], right[i * step])) << i;
+
+		return bits;
+	}
+
+	template <typename Left, typename Right>
+	std::uint64_t compareBlock(token::Operator::Type comparison, const Left* left, const Right* right, std::size_t step, std::size_t count)
+	{
+		switch (comparison)
+		{
+			case token::Operator::Equality:			return compareRun<token::Operator::Equality>(left, right, step, count);
+			case token::Operator::Inequality:		return compareRun<token::Operator::Inequality>(left, right, step, count);
+			case token::Operator::LessThan:			return compareRun<token::Operator::LessThan>(left, right, step, count);
+			case token::Operator::LessThanEqual:	return compareRun<token::Operator::LessThanEqual>(left, right, step, count);
+			case token::Operator::GreaterThan:		return compareRun<token::Operator::GreaterThan>(left, right, step, count);
+			default:								return compareRun<token::Operator::GreaterThanEqual>(left, right, step, count);
+		}
+	}
+
+	//	a mask with the bit of every row set
+	std::vector<std::uint64_t> allRows(std::size_t rows)
+	{
+		std::vector<std::uint64_t> mask((rows + BlockRows - 1) / BlockRows, ~std::uint64_t(0));
+		if (rows % BlockRows)
+			mask.back() = (std::uint64_t(1) << rows % BlockRows) - 1;
+
+		return mask;
+	}
+
+	//	the value a kernel compares a constant as: a Currency is compared with integers exactly, which its Float value
+	//	only matches when it is a whole number or small enough for its rounding to stay clear of the integers
+	std::optional<token::operand::Type> comparedValue(const token::operand::Ptr& constant)
+	{
+		constexpr auto Exact = (1ll << 40) * token::operand::Currency::Scale;
+
+		if (const auto currency = dynamic_cast<const token::operand::Currency*>(constant.get())) {
+			if (currency->getScaled() % token::operand::Currency::Scale == 0)
+				return currency->getScaled() / token::operand::Currency::Scale;
+			if (currency->getScaled() <= -Exact || currency->getScaled() >= Exact)
+				return {};
+		}
+
+		return constant->getValue();
+	}
+
+	bool isTrue(const token::operand::Ptr& operand)
+	{
+		return std::visit([] (auto&& val) { return val != 0; }, operand->getValue());
+	}
+}
+
+compiled::Filter::Filter(const Expression& expression, const Bindings& constants)
+	:
+	program(expression.specialize(constants))
+{
+	const auto& instructions = program.getInstructions();
+
+	starts.resize(instructions.size());
+	operands.resize(instructions.size(), {None, None});
+
+	//	a program that isn't a single tree leaves its operands to the row by row evaluation, as a whole
+	std::vector<std::size_t> stack;
+	auto isTree = true;
+
+	for (auto i = std::size_t(0); i < instructions.size() && isTree; ++i)
+	{
+		starts[i] = i;
+
+		if (instructions[i].code == Instruction::Code::Operation) {
+			const auto arity = static_cast<std::size_t>(std::max(instructions[i].operation.arity, 1));
+
+			if (stack.size() < arity) {
+				isTree = false;
+				break;
+			}
+
+			std::copy(std::end(stack) - arity, std::end(stack), std::begin(operands[i]));
+			starts[i] = starts[operands[i][0]];
+			stack.resize(stack.size() - arity);
+		}
+
+		stack.push_back(i);
+	}
+
+	if (isTree && stack.size() == 1)
+		root = plan(instructions.size() - 1);
+	else {
+		root.kind = Step::Kind::Rows;
+		root.first = 0;
+		root.last = instructions.size();
+	}
+}
+
+std::vector<std::uint64_t> compiled::Filter::mask(const std::vector<Column>& columns, std::size_t rows) const
+{
+	check(columns, rows);
+
+	auto mask = allRows(rows);
+	run(root, columns, rows, mask);
+	return mask;
+}
+
+std::vector<std::uint64_t> compiled::Filter::mask(const std::vector<Column>& columns, std::size_t rows, const ZoneMap& zones) const
+{
+	check(columns, rows);
+
+	if (zones.blockRows == 0 || zones.blockRows % BlockRows)
+		throw std::runtime_error("Zones must span a multiple of " + std::to_string(BlockRows) + " rows");
+
+	const auto zoneCount = (rows + zones.blockRows - 1) / zones.blockRows;
+	const auto wordsPerZone = zones.blockRows / BlockRows;
+
+	std::vector<Interval> slots(program.getAliases().size(), Interval {-Infinity, Infinity, true, false});
+	std::vector<std::size_t> read;
+
+	for (const auto& instruction : program.getInstructions())
+		if (instruction.code == Instruction::Code::Variable && !utils::contains(read, instruction.slot)) {
+			if (instruction.slot >= zones.zones.size() || zones.zones[instruction.slot].size() < zoneCount)
+				throw std::runtime_error("No zones for column '" + program.getAliases()[instruction.slot] + "'");
+			read.push_back(instruction.slot);
+		}
+
+	//	the zones always true are kept as they are, only the undecided ones run the steps
+	auto passed = allRows(rows), undecided = passed;
+
+	for (auto zone = std::size_t(0); zone < zoneCount; ++zone)
+	{
+		for (const auto slot : read)
+			slots[slot] = zones.zones[slot][zone];
+
+		const auto first = zone * wordsPerZone, last = std::min(first + wordsPerZone, passed.size());
+		const auto clear = [first, last] (std::vector<std::uint64_t>& mask) { std::fill(std::begin(mask) + first, std::begin(mask) + last, 0); };
+
+		switch (decide(program, slots))
+		{
+			case Truth::True:
+				clear(undecided);
+				break;
+
+			case Truth::False:
+				clear(passed);
+				clear(undecided);
+				break;
+
+			case Truth::Unknown:
+				clear(passed);
+				break;
+		}
+	}
+
+	run(root, columns, rows, undecided);
+
+	for (auto block = std::size_t(0); block < passed.size(); ++block)
+		passed[block] |= undecided[block];
+
+	return passed;
+}
+
+std::vector<std::size_t> compiled::Filter::select(const std::vector<Column>& columns, std::size_t rows) const
+{
+	return toSelection(mask(columns, rows));
+}
+
+std::vector<std::size_t> compiled::Filter::select(const std::vector<Column>& columns, std::size_t rows, const ZoneMap& zones) const
+{
+	return toSelection(mask(columns, rows, zones));
+}
+
+void compiled::Filter::check(const std::vector<Column>& columns, std::size_t rows) const
+{
+	for (const auto& instruction : program.getInstructions())
+	{
+		if (instruction.code != Instruction::Code::Variable)
+			continue;
+
+		const auto& alias = program.getAliases()[instruction.slot];
+
+		if (instruction.slot >= columns.size())
+			throw std::runtime_error("No column or value for variable '" + alias + "'");
+
+		if (std::visit([] (const auto& values) { return values.size(); }, columns[instruction.slot]) < rows)
+			throw std::runtime_error("Column '" + alias + "' has fewer than " + std::to_string(rows) + " rows");
+	}
+}
+
+compiled::Filter::Step compiled::Filter::plan(std::size_t node) const
+{
+	const auto& instruction = program.getInstructions()[node];
+	const auto [left, right] = operands[node];
+
+	Step step {Step::Kind::Rows, false, token::Operator::Equality, {}, {}, {}, starts[node], node + 1};
+
+	if (instruction.code == Instruction::Code::Constant) {
+		step.kind = Step::Kind::Constant;
+		step.passes = isTrue(instruction.constant);
+		return step;
+	}
+
+	if (instruction.code != Instruction::Code::Operation)
+		return step;
+
+	const auto type = instruction.operation.type;
+	const auto bothBoolean = right != None && isBoolean(left) && isBoolean(right);
+
+	if (type == token::Operator::AndAlso || type == token::Operator::OrElse || (bothBoolean && (type == token::Operator::And || type == token::Operator::Or))) {
+		step.kind = type == token::Operator::AndAlso || type == token::Operator::And ? Step::Kind::Conjunction : Step::Kind::Disjunction;
+
+		//	nested conjunctions (or disjunctions) become one list of steps, run in the order they were written
+		for (const auto operand : {left, right}) {
+			auto nested = plan(operand);
+
+			if (nested.kind == step.kind)
+				std::move(std::begin(nested.steps), std::end(nested.steps), std::back_inserter(step.steps));
+			else
+				step.steps.push_back(std::move(nested));
+		}
+	}
+	else if (type == token::Operator::Not && isBoolean(left)) {
+		step.kind = Step::Kind::Negation;
+		step.steps.push_back(plan(left));
+	}
+	else if (isComparison(type) && right != None) {
+		const auto& instructions = program.getInstructions();
+
+		const auto valueOf = [&instructions] (std::size_t operand) -> std::optional<Value> {
+			switch (instructions[operand].code)
+			{
+				case Instruction::Code::Constant:
+					if (const auto value = comparedValue(instructions[operand].constant))
+						return Value {true, 0, *value};
+					return {};
+
+				case Instruction::Code::Variable:	return Value {false, instructions[operand].slot, {}};
+				default:							return {};
+			}
+		};
+
+		const auto lhs = valueOf(left), rhs = valueOf(right);
+
+		if (lhs && rhs && !(lhs->constant && rhs->constant)) {
+			step.kind = Step::Kind::Compare;
+			step.comparison = lhs->constant ? mirrored(type) : type;
+			step.left = lhs->constant ? *rhs : *lhs;
+			step.right = lhs->constant ? *lhs : *rhs;
+		}
+	}
+
+	return step;
+}
+
+//	true when the subtree gives True or False, so that the bitwise operators on it are the logical ones
+bool compiled::Filter::isBoolean(std::size_t node) const
+{
+	const auto& instruction = program.getInstructions()[node];
+
+	if (instruction.code == Instruction::Code::Constant)
+		return dynamic_cast<const token::operand::Boolean*>(instruction.constant.get()) != nullptr;
+
+	if (instruction.code != Instruction::Code::Operation)
+		return false;
+
+	switch (const auto [left, right] = operands[node]; instruction.operation.type)
+	{
+		case token::Operator::AndAlso:
+		case token::Operator::OrElse:
+			return true;
+
+		case token::Operator::Not:
+			return isBoolean(left);
+
+		case token::Operator::And:
+		case token::Operator::Or:
+		case token::Operator::Xor:
+			return isBoolean(left) && isBoolean(right);
+
+		default:
+			return isComparison(instruction.operation.type);
+	}
+}
+
+//	clears the bits of the rows in 'mask' that don't pass the step; rows whose bit is already clear are not evaluated
+void compiled::Filter::run(const Step& step, const std::vector<Column>& columns, std::size_t rows, std::vector<std::uint64_t>& mask) const
+{
+	const auto any = [] (const std::vector<std::uint64_t>& words) { return std::any_of(std::begin(words), std::end(words), [] (std::uint64_t word) { return word != 0; }); };
+
+	switch (step.kind)
+	{
+		case Step::Kind::Constant:
+			if (!step.passes)
+				std::fill(std::begin(mask), std::end(mask), 0);
+			break;
+
+		case Step::Kind::Compare:
+			std::visit([&] (const auto& left) {
+				using Left = typename std::decay_t<decltype(left)>::value_type;
+
+				const auto compare = [&] (const auto* right, std::size_t stride) {
+					for (auto block = std::size_t(0); block < mask.size(); ++block)
+						if (mask[block]) {
+							const auto offset = block * BlockRows;
+							mask[block] &= compareBlock(step.comparison, left.data() + offset, right + offset * stride, stride, std::min(BlockRows, rows - offset));
+						}
+				};
+
+				if (!step.right.constant)
+					std::visit([&compare] (const auto& right) { compare(right.data(), 1); }, columns[step.right.slot]);
+				else
+					std::visit([&compare] (auto constant) {
+						//	an integer is compared with a float as a float, so the conversion is done once here
+						if constexpr (std::is_same_v<Left, double>) {
+							const auto value = static_cast<double>(constant);
+							compare(&value, 0);
+						}
+						else
+							compare(&constant, 0);
+					}, step.right.value);
+			}, columns[step.left.slot]);
+			break;
+
+		case Step::Kind::Conjunction:
+			for (const auto& conjunct : step.steps)
+				if (any(mask))
+					run(conjunct, columns, rows, mask);
+			break;
+
+		case Step::Kind::Disjunction: {
+			std::vector<std::uint64_t> passed(mask.size());
+
+			for (const auto& disjunct : step.steps)
+			{
+				if (!any(mask))
+					break;
+
+				auto current = mask;
+				run(disjunct, columns, rows, current);
+
+				for (auto block = std::size_t(0); block < mask.size(); ++block) {
+					passed[block] |= current[block];
+					mask[block] &= ~current[block];
+				}
+			}
+
+			mask = std::move(passed);
+			break;
+		}
+
+		case Step::Kind::Negation: {
+			auto negated = mask;
+			run(step.steps.front(), columns, rows, negated);
+
+			for (auto block = std::size_t(0); block < mask.size(); ++block)
+				mask[block] &= ~negated[block];
+			break;
+		}
+
+		case Step::Kind::Rows:
+			for (auto block = std::size_t(0); block < mask.size(); ++block)
+				for (auto bits = mask[block]; bits; bits &= bits - 1)
+					if (const auto bit = firstSet(bits); !passes(step, columns, block * BlockRows + bit))
+						mask[block] &= ~(std::uint64_t(1) << bit);
+			break;
+	}
+}
+
+bool compiled::Filter::passes(const Step& step, const std::vector<Column>& columns, std::size_t row) const
+{
+	const auto& instructions = program.getInstructions();
+	std::vector<token::operand::Ptr> stack;
+
+	for (auto i = step.first; i < step.last; ++i)
+	{
+		switch (instructions[i].code)
+		{
+			case Instruction::Code::Constant:
+				stack.push_back(instructions[i].constant);
+				break;
+
+			case Instruction::Code::Variable:
+				stack.push_back(std::visit([row] (const auto& values) -> token::operand::Ptr {
+					using T = typename std::decay_t<decltype(values)>::value_type;
+
+					if constexpr (std::is_same_v<T, double>)
+						return std::make_shared<token::operand::Float>(values[row]);
+					else
+						return std::make_shared<token::operand::Integer>(values[row]);
+				}, columns[instructions[i].slot]));
+				break;
+
+			case Instruction::Code::Operation:
+				apply(instructions[i].operation, stack);
+				break;
+		}
+	}
+
+	if (stack.empty())
+		throw std::runtime_error("Empty expression");
+
+	return isTrue(stack.back());
+}
+
+compiled::ZoneMap compiled::zoneMap(const std::vector<Column>& columns, std::size_t rows, std::size_t blockRows)
+{
+	if (blockRows == 0 || blockRows % BlockRows)
+		throw std::runtime_error("Zones must span a multiple of " + std::to_string(BlockRows) + " rows");
+
+	ZoneMap map {blockRows, std::vector<std::vector<Interval>>(columns.size())};
+
+	for (auto slot = std::size_t(0); slot < columns.size(); ++slot)
+		std::visit([&map, slot, rows, blockRows] (const auto& values) {
+			using T = typename std::decay_t<decltype(values)>::value_type;
+
+			for (auto first = std::size_t(0); first < std::min(rows, values.size()); first += blockRows)
+			{
+				const auto last = std::min({first + blockRows, rows, values.size()});
+				Interval zone {Infinity, -Infinity, false, std::is_integral_v<T>};
+
+				for (auto row = first; row < last; ++row) {
+					if constexpr (std::is_same_v<T, double>) {
+						if (values[row] != values[row]) {
+							zone.nan = true;
+							continue;
+						}
+					}
+
+					zone.lo = std::min<double>(zone.lo, values[row]);
+					zone.hi = std::max<double>(zone.hi, values[row]);
+				}
+
+				//	a zone of NaN alone still needs a range, and an integer beyond 2^53 may have been rounded inwards
+				if (zone.lo > zone.hi)
+					zone.lo = zone.hi = 0;
+				else if (std::is_integral_v<T> && std::max(-zone.lo, zone.hi) >= 9007199254740992.0) {
+					zone.lo = std::nextafter(zone.lo, -Infinity);
+					zone.hi = std::nextafter(zone.hi, Infinity);
+				}
+
+				map.zones[slot].push_back(zone);
+			}
+		}, columns[slot]);
+
+	return map;
+}
+
+std::vector<std::size_t> compiled::toSelection(const std::vector<std::uint64_t>& mask)
+{
+	std::vector<std::size_t> selection;
+
+	for (auto block = std::size_t(0); block < mask.size(); ++block)
+		for (auto bits = mask[block]; bits; bits &= bits - 1)
+			selection.push_back(block * BlockRows + firstSet(bits));
+
+	return selection;
+}
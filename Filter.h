@@ -0,0 +1,91 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "Expression.h"
+#include "Interval.h"
+#include "Operator.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace compiled
+{
+	//	the value of one variable in every row, as integers (booleans as -1 and 0) or as floats
+	using Column = std::variant<std::vector<long long>, std::vector<double>>;
+
+	//	the range of every column over consecutive blocks of rows, such as the min/max statistics kept with columnar data
+	struct ZoneMap
+	{
+		std::size_t blockRows;							//	a multiple of 64
+		std::vector<std::vector<Interval>> zones;		//	by slot, then by block
+	};
+
+	//	a predicate evaluated over columns, telling only which rows pass (give a value other than 0)
+	//
+	//	AndAlso, OrElse and the bitwise And, Or and Not of comparisons are split into steps, and each step runs only on the
+	//	rows the previous ones left undecided, so an error in a row an earlier conjunct rejected is not reported.
+	//	comparisons between columns and constants run as compare-and-mask kernels over blocks of 64 rows, and blocks
+	//	without an undecided row are skipped; any other operand is evaluated row by row as Expression::evaluate would.
+	//	given a zone map, the predicate is first bounded over the ranges of each zone, and only the zones where it is
+	//	neither always true nor always false are evaluated
+	class Filter
+	{
+		public:
+			//	slots bound in 'constants' are folded in, every other slot reads the column with the same index
+			Filter(const Expression& expression, const Bindings& constants);
+
+			//	one bit per row, row i at bit i % 64 of word i / 64
+			std::vector<std::uint64_t> mask(const std::vector<Column>& columns, std::size_t rows) const;
+
+			std::vector<std::uint64_t> mask(const std::vector<Column>& columns, std::size_t rows, const ZoneMap& zones) const;
+
+			//	the indices of the rows that pass, in ascending order
+			std::vector<std::size_t> select(const std::vector<Column>& columns, std::size_t rows) const;
+			std::vector<std::size_t> select(const std::vector<Column>& columns, std::size_t rows, const ZoneMap& zones) const;
+
+		private:
+			//	a column or a constant converted to a column's type
+			struct Value
+			{
+				bool constant;
+				std::size_t slot;
+				token::operand::Type value;
+			};
+
+			struct Step
+			{
+				enum class Kind { Constant, Compare, Conjunction, Disjunction, Negation, Rows };
+
+				Kind kind;
+				bool passes;							//	Constant
+				token::Operator::Type comparison;		//	Compare, with the constant (if any) on the right
+				Value left, right;
+				std::vector<Step> steps;				//	Conjunction, Disjunction, Negation
+				std::size_t first, last;				//	Rows: the instructions of the subtree
+			};
+
+			void check(const std::vector<Column>& columns, std::size_t rows) const;
+
+			Step plan(std::size_t node) const;
+			bool isBoolean(std::size_t node) const;
+
+			void run(const Step& step, const std::vector<Column>& columns, std::size_t rows, std::vector<std::uint64_t>& mask) const;
+			bool passes(const Step& step, const std::vector<Column>& columns, std::size_t row) const;
+
+			Expression program;
+			std::vector<std::size_t> starts;						//	first instruction of the subtree of every instruction
+			std::vector<std::array<std::size_t, 2>> operands;		//	instructions giving the operands of every operation
+			Step root;
+	};
+
+	//	the range of every column over blocks of 'blockRows' rows, NaN aside
+	ZoneMap zoneMap(const std::vector<Column>& columns, std::size_t rows, std::size_t blockRows);
+
+	//	the indices of the bits set in a mask, in ascending order
+	std::vector<std::size_t> toSelection(const std::vector<std::uint64_t>& mask);
+}
+
+#endif
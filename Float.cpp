@@ -2,9 +2,12 @@
 
 #include "Utils.h"
 
+#include <charconv>
+#include <cmath>
 #include <iomanip>
-#include <locale>
+#include <limits>
 #include <sstream>
+#include <string>
 
 token::operand::Float::Float() : Float(0.0)
 { }
@@ -14,14 +17,58 @@ token::operand::Float::Float(double value) : value(value)
 
 std::optional<std::string_view> token::operand::Float::parse(std::string_view expression, Context& context)
 {
-	auto charactersParsed = 0u;
+	const auto sign = !expression.empty() && (expression.front() == '-' || expression.front() == '+') ? 1u : 0u;
+
+	//	hexadecimal floats are rare enough to keep going through the C library
+	if (expression.substr(sign, 2) == "0x" || expression.substr(sign, 2) == "0X")
+		return parseHexadecimal(expression, context);
+
+	auto charactersParsed = sign + utils::str::countDigits(expression.substr(sign));
+	const auto dot = charactersParsed;
+
+	if (dot >= expression.size() || expression[dot] != '.')
+		return {};
+
+	const auto fraction = utils::str::countDigits(expression.substr(dot + 1));
+	if (dot == sign && !fraction)
+		return {};
+
+	charactersParsed = dot + 1 + fraction;
+
+	if (charactersParsed < expression.size() && (expression[charactersParsed] == 'e' || expression[charactersParsed] == 'E')) {
+		auto exponent = charactersParsed + 1;
+		if (exponent < expression.size() && (expression[exponent] == '-' || expression[exponent] == '+'))
+			++exponent;
+
+		if (const auto digits = utils::str::countDigits(expression.substr(exponent)))
+			charactersParsed = exponent + digits;
+	}
+
+	if (expression.substr(dot + 1).empty() || utils::str::isClass(expression[dot + 1], utils::str::Space))
+		return {};
+
+	auto parsedValue = 0.0;
+
+	//	std::from_chars accepts a leading '-' but not a '+'
+	const auto first = expression.data() + (expression.front() == '+' ? 1 : 0);
+	if (std::from_chars(first, expression.data() + charactersParsed, parsedValue).ec != std::errc())
+		return {};
+
+	context.lastToken = Context::TokenType::Operand;
+	value = parsedValue;
+	return utils::str::skipWhitespace(expression.substr(charactersParsed));
+}
+
+std::optional<std::string_view> token::operand::Float::parseHexadecimal(std::string_view expression, Context& context)
+{
+	std::size_t charactersParsed = 0;
 	auto parsedValue = 0.0;
 
-	try { parsedValue = std::stod(expression.data(), &charactersParsed); }
+	try { parsedValue = std::stod(std::string(expression), &charactersParsed); }
 	catch (...) { return {}; }
 
 	const auto dot = expression.substr(0, charactersParsed).find('.');
-	if (dot == std::string_view::npos || expression.substr(dot + 1).empty() || std::isspace(expression[dot + 1], std::locale::classic()))
+	if (dot == std::string_view::npos || expression.substr(dot + 1).empty() || utils::str::isClass(expression[dot + 1], utils::str::Space))
 		return {};
 
 	context.lastToken = Context::TokenType::Operand;
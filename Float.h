@@ -16,6 +16,8 @@ namespace token::operand
 			std::string toString() const override;
 
 		private:
+			std::optional<std::string_view> parseHexadecimal(std::string_view expression, Context& context);
+
 			double value;
 	};
 }
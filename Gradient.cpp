@@ -0,0 +1,162 @@
+#include "Gradient.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+namespace
+{
+	//	an operand on the tape with the derivative of its value with respect to each of its own operands
+	struct Entry
+	{
+		std::size_t operands[2];
+		double partials[2];
+		std::size_t slot;
+	};
+
+	constexpr auto None = ~std::size_t(0);
+
+	double toDouble(const token::operand::Ptr& operand)
+	{
+		return std::visit([] (auto&& val) { return static_cast<double>(val); }, operand->getValue());
+	}
+
+	//	derivatives of the unary operation at 'x' giving 'result'
+	double derivative(token::Operator::Type type, double x, double result)
+	{
+		switch (type)
+		{
+			case token::Operator::Positive:	return 1.0;
+			case token::Operator::Negative:	return -1.0;
+			case token::Operator::Abs:		return x > 0 ? 1.0 : x < 0 ? -1.0 : 0.0;
+			case token::Operator::Acos:		return -1.0 / std::sqrt(1.0 - x * x);
+			case token::Operator::Asin:		return 1.0 / std::sqrt(1.0 - x * x);
+			case token::Operator::Atan:		return 1.0 / (1.0 + x * x);
+			case token::Operator::Cos:		return -std::sin(x);
+			case token::Operator::Sin:		return std::cos(x);
+			case token::Operator::Tan:		return 1.0 / (std::cos(x) * std::cos(x));
+			case token::Operator::Exp:		return result;
+			case token::Operator::Log:		return 1.0 / x;
+			case token::Operator::Log10:	return 1.0 / (x * std::log(10.0));
+			case token::Operator::Sqrt:		return 0.5 / result;
+			default:						return 0.0;
+		}
+	}
+
+	//	derivatives of the binary operation at 'x' and 'y' giving 'result', with respect to 'x' and to 'y'
+	std::pair<double, double> derivatives(token::Operator::Type type, double x, double y, double result)
+	{
+		switch (type)
+		{
+			case token::Operator::Sum:				return {1.0, 1.0};
+			case token::Operator::Difference:		return {1.0, -1.0};
+			case token::Operator::Multiplication:	return {y, x};
+			case token::Operator::FloatDivision:	return {1.0 / y, -x / (y * y)};
+			case token::Operator::Mod:				return {1.0, -std::trunc(x / y)};
+
+			case token::Operator::Power:
+			case token::Operator::IntegerPower: {
+				const auto byBase = y == 0 ? 0.0 : y * std::pow(x, y - 1);
+
+				if (x > 0)
+					return {byBase, result * std::log(x)};
+				if (x == 0 && y > 0)
+					return {byBase, 0.0};
+				return {byBase, std::numeric_limits<double>::quiet_NaN()};
+			}
+
+			default:								return {0.0, 0.0};
+		}
+	}
+}
+
+compiled::Gradient compiled::gradient(const Expression& expression, const Bindings& bindings)
+{
+	std::vector<Entry> tape;
+	std::vector<token::operand::Ptr> operands;
+	std::vector<std::size_t> entries;
+
+	tape.reserve(expression.getInstructions().size());
+	operands.reserve(expression.getInstructions().size());
+
+	for (const auto& instruction : expression.getInstructions())
+	{
+		switch (instruction.code)
+		{
+			case Instruction::Code::Constant:
+				operands.push_back(instruction.constant);
+				entries.push_back(tape.size());
+				tape.push_back({{None, None}, {0.0, 0.0}, None});
+				break;
+
+			case Instruction::Code::Variable:
+				if (instruction.slot < bindings.size() && bindings[instruction.slot]) {
+					operands.push_back(bindings[instruction.slot]);
+					entries.push_back(tape.size());
+					tape.push_back({{None, None}, {0.0, 0.0}, instruction.slot});
+				}
+				break;
+
+			case Instruction::Code::Operation: {
+				const auto arity = static_cast<std::size_t>(std::max(instruction.operation.arity, 1));
+				if (operands.size() < arity)
+					throw std::runtime_error("Missing operand");
+
+				Entry entry {{None, None}, {0.0, 0.0}, None};
+				const auto first = operands.size() - arity;
+
+				if (arity == 1) {
+					const auto x = toDouble(operands[first]);
+					apply(instruction.operation, operands);
+
+					entry.operands[0] = entries[first];
+					entry.partials[0] = derivative(instruction.operation.type, x, toDouble(operands.back()));
+				}
+				else {
+					const auto x = toDouble(operands[first]), y = toDouble(operands[first + 1]);
+					apply(instruction.operation, operands);
+
+					const auto [byX, byY] = derivatives(instruction.operation.type, x, y, toDouble(operands.back()));
+					entry.operands[0] = entries[first];
+					entry.operands[1] = entries[first + 1];
+					entry.partials[0] = byX;
+					entry.partials[1] = byY;
+				}
+
+				entries.resize(first);
+				entries.push_back(tape.size());
+				tape.push_back(entry);
+				break;
+			}
+		}
+	}
+
+	if (operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	Gradient result {operands.back(), std::vector<double>(expression.getAliases().size(), 0.0)};
+
+	//	the backward sweep: every entry comes after its operands, so its adjoint is final when it is reached
+	std::vector<double> adjoints(tape.size(), 0.0);
+	adjoints[entries.back()] = 1.0;
+
+	for (auto i = tape.size(); i-- > 0;)
+	{
+		const auto& entry = tape[i];
+
+		//	entries that don't reach the result are skipped, so their infinite or NaN partials can't leak into it
+		if (adjoints[i] == 0.0)
+			continue;
+
+		if (entry.slot != None)
+			result.partials[entry.slot] += adjoints[i];
+
+		for (auto operand = 0; operand < 2 && entry.operands[operand] != None; ++operand)
+			adjoints[entry.operands[operand]] += adjoints[i] * entry.partials[operand];
+	}
+
+	return result;
+}
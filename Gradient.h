@@ -0,0 +1,25 @@
+#ifndef GRADIENT_H
+#define GRADIENT_H
+
+#include "Expression.h"
+#include "Operand.h"
+
+#include <vector>
+
+namespace compiled
+{
+	struct Gradient
+	{
+		token::operand::Ptr value;			//	the same result as Expression::evaluate
+		std::vector<double> partials;		//	derivative of the value with respect to every slot, 0 for unbound slots
+	};
+
+	//	value and every partial derivative in one forward and one backward (adjoint) sweep
+	//
+	//	integers and booleans are differentiated as the reals they convert to; operators that are piecewise constant
+	//	(integer division, comparisons, logical and bitwise operators, Ceil, Floor, Round, Truncate) have a zero derivative,
+	//	and Abs takes 0 at 0. where a derivative is undefined (e.g. Sqrt at 0, Log of a negative) it is NaN or infinite
+	Gradient gradient(const Expression& expression, const Bindings& bindings);
+}
+
+#endif
@@ -2,7 +2,7 @@
 
 #include "Utils.h"
 
-#include <locale>
+#include <charconv>
 
 token::operand::Integer::Integer() : Integer(0ll)
 { }
@@ -12,14 +12,20 @@ token::operand::Integer::Integer(long long value) : value(value)
 
 std::optional<std::string_view> token::operand::Integer::parse(std::string_view expression, Context& context)
 {
-	auto charactersParsed = 0u;
+	const auto sign = !expression.empty() && (expression.front() == '-' || expression.front() == '+') ? 1u : 0u;
+	const auto digits = utils::str::countDigits(expression.substr(sign));
+	if (!digits) return {};
+
+	const auto charactersParsed = sign + digits;
 	auto parsedValue = 0ll;
 
-	try { parsedValue = std::stoll(expression.data(), &charactersParsed); }
-	catch (...) { return {}; }
+	//	std::from_chars accepts a leading '-' but not a '+'
+	const auto first = expression.data() + (expression.front() == '+' ? 1 : 0);
+	if (std::from_chars(first, expression.data() + charactersParsed, parsedValue).ec != std::errc())
+		return {};
 
 	const auto suffix = expression.substr(charactersParsed);
-	if (!suffix.empty() && (std::isalpha(suffix.front(), std::locale::classic()) || suffix.front() == '.'))
+	if (!suffix.empty() && (utils::str::isClass(suffix.front(), utils::str::Alpha) || suffix.front() == '.'))
 		return {};
 
 	context.lastToken = Context::TokenType::Operand;
@@ -0,0 +1,435 @@
+#include "Interval.h"
+
+#include "Currency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <variant>
+
+namespace
+{
+	using compiled::Interval;
+	using compiled::Truth;
+
+	constexpr auto Infinity = std::numeric_limits<double>::infinity();
+
+	//	integers below 2^53 are exact as doubles, so are the sums and products of theirs that stay below it
+	constexpr auto Exact = 9007199254740992.0;
+	constexpr auto Int64 = 9223372036854775808.0;
+
+	constexpr Interval Anything {-Infinity, Infinity, true, false};
+	constexpr Interval AnyInteger {-Int64, Int64, false, true};
+	constexpr Interval TrueValue {-1, -1, false, true}, FalseValue {0, 0, false, true}, EitherValue {-1, 0, false, true};
+
+	bool contains(const Interval& interval, double value)
+	{
+		return interval.lo <= value && value <= interval.hi;
+	}
+
+	bool hasInfinity(const Interval& interval)
+	{
+		return std::isinf(interval.lo) || std::isinf(interval.hi);
+	}
+
+	Interval boolean(Truth truth)
+	{
+		return truth == Truth::True ? TrueValue : truth == Truth::False ? FalseValue : EitherValue;
+	}
+
+	//	NaN is a value other than 0 too, so only an interval of 0 alone never passes
+	Truth truthOf(const Interval& value)
+	{
+		if (value.lo > 0 || value.hi < 0)
+			return Truth::True;
+		if (value.lo == 0 && value.hi == 0 && !value.nan)
+			return Truth::False;
+
+		return Truth::Unknown;
+	}
+
+	//	one unit in the last place wider, for the library functions that aren't always correctly rounded
+	Interval widened(Interval interval)
+	{
+		interval.lo = std::nextafter(interval.lo, -Infinity);
+		interval.hi = std::nextafter(interval.hi, Infinity);
+		return interval;
+	}
+
+	//	an integer result is only known while it can't have overflowed or been rounded
+	Interval checked(const Interval& interval)
+	{
+		if (interval.integer && (interval.lo <= -Exact || interval.hi >= Exact))
+			return AnyInteger;
+
+		return interval;
+	}
+
+	//	the range of an operation monotonic in each operand, from its results at the corners
+	Interval spanning(std::initializer_list<double> corners, bool nan, bool integer)
+	{
+		if (std::any_of(std::begin(corners), std::end(corners), [] (double corner) { return std::isnan(corner); }))
+			return integer ? AnyInteger : Anything;
+
+		const auto [lo, hi] = std::minmax(corners);
+		return checked({lo, hi, nan, integer});
+	}
+
+	//	the values std::llrint gives over the interval, or nothing when they aren't all exact as doubles
+	std::optional<Interval> rounded(const Interval& interval)
+	{
+		if (interval.nan || interval.lo <= -Exact || interval.hi >= Exact)
+			return {};
+
+		return Interval {std::nearbyint(interval.lo), std::nearbyint(interval.hi), false, true};
+	}
+
+	template <typename Function>
+	Interval increasing(Function&& function, const Interval& x, double low, double high)
+	{
+		return widened({function(std::clamp(x.lo, low, high)), function(std::clamp(x.hi, low, high)), x.nan || x.lo < low || x.hi > high, false});
+	}
+
+	template <typename Function>
+	Interval decreasing(Function&& function, const Interval& x, double low, double high)
+	{
+		return widened({function(std::clamp(x.hi, low, high)), function(std::clamp(x.lo, low, high)), x.nan || x.lo < low || x.hi > high, false});
+	}
+
+	//	a Currency computed exactly lies within a ten-thousandth of the same operation on its Float bounds, or a relative
+	//	2^-40 where that is wider, which also covers the rounding of those bounds
+	Interval monetary(const Interval& interval)
+	{
+		const auto slack = std::max(1e-4, std::ldexp(std::max(std::abs(interval.lo), std::abs(interval.hi)), -40));
+		return {interval.lo - slack, interval.hi + slack, interval.nan, false, true};
+	}
+
+	//	whether the operation gives a Currency, as Operator::compute decides from the types of its operands
+	bool givesCurrency(token::Operator::Type type, const Interval& left, const Interval& right)
+	{
+		const auto exact = [] (const Interval& value) { return value.integer || value.currency; };
+
+		switch (type)
+		{
+			case token::Operator::Sum:
+			case token::Operator::Difference:
+			case token::Operator::Multiplication:
+			case token::Operator::Mod:
+				return (left.currency || right.currency) && exact(left) && exact(right);
+
+			default:
+				return false;
+		}
+	}
+
+	bool givesCurrency(token::Operator::Type type, const Interval& operand)
+	{
+		switch (type)
+		{
+			case token::Operator::Negative:
+			case token::Operator::Abs:
+			case token::Operator::Ceil:
+			case token::Operator::Floor:
+			case token::Operator::Truncate:
+				return operand.currency;
+
+			default:
+				return false;
+		}
+	}
+
+	Interval constantOf(const token::operand::Ptr& constant)
+	{
+		if (dynamic_cast<const token::operand::Currency*>(constant.get()))
+			return monetary({std::get<double>(constant->getValue()), std::get<double>(constant->getValue()), false, false});
+
+		return std::visit([] (auto&& val) -> Interval {
+			using T = std::decay_t<decltype(val)>;
+
+			if constexpr (std::is_same_v<T, double>)
+				return std::isnan(val) ? Interval {0, 0, true, false} : Interval {val, val, false, false};
+			else {
+				const auto value = static_cast<double>(val);
+				return std::abs(value) < Exact ? Interval {value, value, false, true} : widened({value, value, false, true});
+			}
+		}, constant->getValue());
+	}
+
+	Truth compare(token::Operator::Type comparison, const Interval& left, const Interval& right)
+	{
+		const auto nan = left.nan || right.nan;
+		const auto disjoint = left.hi < right.lo || right.hi < left.lo;
+		const auto same = left.lo == left.hi && right.lo == right.hi && left.lo == right.lo && !nan;
+
+		switch (comparison)
+		{
+			case token::Operator::Equality:
+				return disjoint ? Truth::False : same ? Truth::True : Truth::Unknown;
+
+			case token::Operator::Inequality:
+				return disjoint ? Truth::True : same ? Truth::False : Truth::Unknown;
+
+			case token::Operator::LessThan:
+				return left.hi < right.lo && !nan ? Truth::True : left.lo >= right.hi ? Truth::False : Truth::Unknown;
+
+			case token::Operator::LessThanEqual:
+				return left.hi <= right.lo && !nan ? Truth::True : left.lo > right.hi ? Truth::False : Truth::Unknown;
+
+			case token::Operator::GreaterThan:
+				return compare(token::Operator::LessThan, right, left);
+
+			default:
+				return compare(token::Operator::LessThanEqual, right, left);
+		}
+	}
+
+	//	And, Or and Xor are only bounded on booleans, where they are the logical operators, and on non-negative integers
+	Interval bitwise(token::Operator::Type type, const Interval& left, const Interval& right)
+	{
+		const auto a = rounded(left), b = rounded(right);
+		if (!a || !b)
+			return AnyInteger;
+
+		if (a->lo >= -1 && a->hi <= 0 && b->lo >= -1 && b->hi <= 0) {
+			const auto canBeTrue = [] (const Interval& value) { return value.lo == -1; };
+			const auto mustBeTrue = [] (const Interval& value) { return value.hi == -1; };
+
+			switch (type)
+			{
+				case token::Operator::And:
+					return {canBeTrue(*a) && canBeTrue(*b) ? -1.0 : 0.0, mustBeTrue(*a) && mustBeTrue(*b) ? -1.0 : 0.0, false, true};
+				case token::Operator::Or:
+					return {canBeTrue(*a) || canBeTrue(*b) ? -1.0 : 0.0, mustBeTrue(*a) || mustBeTrue(*b) ? -1.0 : 0.0, false, true};
+				default:
+					return a->lo == a->hi && b->lo == b->hi ? (a->lo != b->lo ? TrueValue : FalseValue) : EitherValue;
+			}
+		}
+
+		if (a->lo >= 0 && b->lo >= 0) {
+			//	every bit up to the highest one either operand can have
+			auto ones = 1.0;
+			while (ones - 1 < std::max(a->hi, b->hi))
+				ones *= 2;
+
+			switch (type)
+			{
+				case token::Operator::And:	return {0, std::min(a->hi, b->hi), false, true};
+				case token::Operator::Or:	return {std::max(a->lo, b->lo), ones - 1, false, true};
+				default:					return {0, ones - 1, false, true};
+			}
+		}
+
+		return AnyInteger;
+	}
+
+	Interval power(const Interval& base, const Interval& exponent)
+	{
+		//	x ^ n for an integer n is monotonic on either side of 0
+		if (exponent.lo == exponent.hi && !exponent.nan && std::trunc(exponent.lo) == exponent.lo && std::abs(exponent.lo) < Exact) {
+			const auto n = exponent.lo;
+
+			if (n == 0)
+				return {1, 1, false, false};
+			if (n < 0 && contains(base, 0))
+				return Anything;
+
+			const auto atLo = std::pow(base.lo, n), atHi = std::pow(base.hi, n);
+
+			if (std::fmod(n, 2) == 0 && contains(base, 0))
+				return {0, std::nextafter(std::max(atLo, atHi), Infinity), base.nan, false};
+
+			return widened(spanning({atLo, atHi}, base.nan, false));
+		}
+
+		//	x ^ y is exp(y * log(x)), monotonic in each operand for a positive x
+		if (base.lo > 0 && !hasInfinity(exponent))
+			return widened(spanning({std::pow(base.lo, exponent.lo), std::pow(base.lo, exponent.hi), std::pow(base.hi, exponent.lo), std::pow(base.hi, exponent.hi)},
+									base.nan || exponent.nan, false));
+
+		return Anything;
+	}
+
+	Interval unary(token::Operator::Type type, const Interval& x)
+	{
+		switch (type)
+		{
+			case token::Operator::Positive:
+				return x;
+
+			case token::Operator::Negative:
+				return checked({-x.hi, -x.lo, x.nan, x.integer});
+
+			case token::Operator::Abs: {
+				const auto lo = std::abs(x.lo), hi = std::abs(x.hi);
+				return checked({contains(x, 0) ? 0 : std::min(lo, hi), std::max(lo, hi), x.nan, x.integer});
+			}
+
+			case token::Operator::Not: {
+				const auto r = rounded(x);
+				return r ? Interval {-r->hi - 1, -r->lo - 1, false, true} : AnyInteger;
+			}
+
+			case token::Operator::Round:
+				return rounded(x).value_or(AnyInteger);
+
+			case token::Operator::Ceil:		return {std::ceil(x.lo), std::ceil(x.hi), x.nan, false};
+			case token::Operator::Floor:	return {std::floor(x.lo), std::floor(x.hi), x.nan, false};
+			case token::Operator::Truncate:	return {std::trunc(x.lo), std::trunc(x.hi), x.nan, false};
+
+			case token::Operator::Sqrt:		return increasing([] (double v) { return std::sqrt(v); }, x, 0, Infinity);
+			case token::Operator::Exp:		return increasing([] (double v) { return std::exp(v); }, x, -Infinity, Infinity);
+			case token::Operator::Log:		return increasing([] (double v) { return std::log(v); }, x, 0, Infinity);
+			case token::Operator::Log10:	return increasing([] (double v) { return std::log10(v); }, x, 0, Infinity);
+			case token::Operator::Asin:		return increasing([] (double v) { return std::asin(v); }, x, -1, 1);
+			case token::Operator::Acos:		return decreasing([] (double v) { return std::acos(v); }, x, -1, 1);
+			case token::Operator::Atan:		return increasing([] (double v) { return std::atan(v); }, x, -Infinity, Infinity);
+
+			case token::Operator::Sin:
+			case token::Operator::Cos:
+				return {-1, 1, x.nan || hasInfinity(x), false};
+
+			default:
+				return Anything;
+		}
+	}
+
+	Interval binary(token::Operator::Type type, const Interval& l, const Interval& r)
+	{
+		const auto nan = l.nan || r.nan;
+		const auto integer = l.integer && r.integer;
+
+		switch (type)
+		{
+			case token::Operator::Sum:
+				if ((l.hi == Infinity && r.lo == -Infinity) || (l.lo == -Infinity && r.hi == Infinity))
+					return Anything;
+				return checked({l.lo + r.lo, l.hi + r.hi, nan, integer});
+
+			case token::Operator::Difference:
+				if ((l.hi == Infinity && r.hi == Infinity) || (l.lo == -Infinity && r.lo == -Infinity))
+					return Anything;
+				return checked({l.lo - r.hi, l.hi - r.lo, nan, integer});
+
+			case token::Operator::Multiplication:
+				if ((contains(l, 0) && hasInfinity(r)) || (contains(r, 0) && hasInfinity(l)))
+					return Anything;
+				return spanning({l.lo * r.lo, l.lo * r.hi, l.hi * r.lo, l.hi * r.hi}, nan, integer);
+
+			case token::Operator::FloatDivision:
+				if (contains(r, 0) || (hasInfinity(l) && hasInfinity(r)))
+					return Anything;
+				return spanning({l.lo / r.lo, l.lo / r.hi, l.hi / r.lo, l.hi / r.hi}, nan, false);
+
+			case token::Operator::IntegerDivision: {
+				const auto a = rounded(l), b = rounded(r);
+				if (!a || !b || contains(*b, 0))
+					return AnyInteger;
+
+				const auto quotient = [] (double x, double y) { return static_cast<double>(static_cast<long long>(x) / static_cast<long long>(y)); };
+				return spanning({quotient(a->lo, b->lo), quotient(a->lo, b->hi), quotient(a->hi, b->lo), quotient(a->hi, b->hi)}, false, true);
+			}
+
+			//	the remainder has the sign of the dividend, and is smaller than both the dividend and the divisor
+			case token::Operator::Mod: {
+				if (integer && contains(r, 0))
+					return AnyInteger;
+
+				const auto divisor = std::max(std::abs(r.lo), std::abs(r.hi)) - (integer ? 1 : 0);
+				return {std::max(-divisor, std::min(l.lo, 0.0)), std::min(divisor, std::max(l.hi, 0.0)), nan || contains(r, 0) || hasInfinity(l), integer};
+			}
+
+			case token::Operator::Power:
+			case token::Operator::IntegerPower:
+				return power(l, r);
+
+			case token::Operator::RightBitshift: {
+				const auto a = rounded(l), shift = rounded(r);
+				if (!a || !shift || shift->lo != shift->hi || shift->lo < 0 || shift->lo > 63)
+					return AnyInteger;
+
+				return {std::floor(std::ldexp(a->lo, -static_cast<int>(shift->lo))), std::floor(std::ldexp(a->hi, -static_cast<int>(shift->lo))), false, true};
+			}
+
+			case token::Operator::Equality:
+			case token::Operator::Inequality:
+			case token::Operator::LessThan:
+			case token::Operator::LessThanEqual:
+			case token::Operator::GreaterThan:
+			case token::Operator::GreaterThanEqual:
+				return boolean(compare(type, l, r));
+
+			case token::Operator::AndAlso: {
+				const auto left = truthOf(l), right = truthOf(r);
+				if (left == Truth::False || right == Truth::False)
+					return FalseValue;
+				return left == Truth::True && right == Truth::True ? TrueValue : EitherValue;
+			}
+
+			case token::Operator::OrElse: {
+				const auto left = truthOf(l), right = truthOf(r);
+				if (left == Truth::True || right == Truth::True)
+					return TrueValue;
+				return left == Truth::False && right == Truth::False ? FalseValue : EitherValue;
+			}
+
+			case token::Operator::And:
+			case token::Operator::Or:
+			case token::Operator::Xor:
+				return bitwise(type, l, r);
+
+			default:
+				return AnyInteger;
+		}
+	}
+}
+
+compiled::Interval compiled::bound(const Expression& expression, const std::vector<Interval>& slots)
+{
+	std::vector<Interval> operands;
+
+	for (const auto& instruction : expression.getInstructions())
+	{
+		switch (instruction.code)
+		{
+			case Instruction::Code::Constant:
+				operands.push_back(constantOf(instruction.constant));
+				break;
+
+			case Instruction::Code::Variable:
+				if (instruction.slot >= slots.size())
+					throw std::runtime_error("No interval for variable '" + expression.getAliases()[instruction.slot] + "'");
+				operands.push_back(slots[instruction.slot]);
+				break;
+
+			case Instruction::Code::Operation: {
+				const auto& operation = instruction.operation;
+				if (operands.size() < static_cast<std::size_t>(std::max(operation.arity, 1)))
+					throw std::runtime_error("Missing operand");
+
+				const auto right = operands.back();
+
+				if (operation.arity <= 1)
+					operands.back() = givesCurrency(operation.type, right) ? monetary(unary(operation.type, right)) : unary(operation.type, right);
+				else {
+					operands.pop_back();
+					const auto left = operands.back();
+					operands.back() = givesCurrency(operation.type, left, right) ? monetary(binary(operation.type, left, right)) : binary(operation.type, left, right);
+				}
+				break;
+			}
+		}
+	}
+
+	if (operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	return operands.back();
+}
+
+compiled::Truth compiled::decide(const Expression& expression, const std::vector<Interval>& slots)
+{
+	return truthOf(bound(expression, slots));
+}
@@ -0,0 +1,34 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "Expression.h"
+
+#include <vector>
+
+namespace compiled
+{
+	//	the values a subexpression can take: every value that isn't NaN lies in [lo, hi], and NaN is possible when 'nan' is set
+	struct Interval
+	{
+		double lo, hi;
+		bool nan;
+		bool integer;		//	every value is an Integer or a Boolean, which decides how the operators treat it
+		bool currency = false;		//	every value is a Currency
+	};
+
+	enum class Truth { False, True, Unknown };
+
+	//	bounds of the value of the expression when every slot takes any value within its interval
+	//
+	//	the bounds are conservative: they hold every result that evaluating the expression could give, and widen
+	//	to the whole range wherever an operator isn't monotonic enough to bound cheaply (bitwise operators on other
+	//	than booleans, Mod, Sin, Cos, Tan, integers beyond 2^53); a Currency result is widened by the rounding of its
+	//	exact arithmetic, at least a ten-thousandth; throws if a slot read has no interval
+	Interval bound(const Expression& expression, const std::vector<Interval>& slots);
+
+	//	True when the expression passes (gives a value other than 0) for every value of the slots, False when it
+	//	passes for none, Unknown otherwise
+	Truth decide(const Expression& expression, const std::vector<Interval>& slots);
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+utils::MappedFile::MappedFile(const std::string& path)
+	:
+	data(nullptr),
+	size(0),
+	file(INVALID_HANDLE_VALUE),
+	mapping(nullptr)
+{
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Cannot open file '" + path + "'");
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		throw std::runtime_error("Cannot read the size of file '" + path + "'");
+	}
+
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	if (size == 0) return;
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping)
+		data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!data) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("Cannot map file '" + path + "'");
+	}
+}
+
+utils::MappedFile::~MappedFile()
+{
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+
+#else
+
+utils::MappedFile::MappedFile(const std::string& path)
+	:
+	data(nullptr),
+	size(0),
+	descriptor(-1)
+{
+	descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		throw std::runtime_error("Cannot open file '" + path + "'");
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		close(descriptor);
+		throw std::runtime_error("Cannot read the size of file '" + path + "'");
+	}
+
+	size = static_cast<std::size_t>(status.st_size);
+	if (size == 0) return;
+
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		close(descriptor);
+		throw std::runtime_error("Cannot map file '" + path + "'");
+	}
+
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	data = static_cast<const char*>(mapped);
+}
+
+utils::MappedFile::~MappedFile()
+{
+	if (data) munmap(const_cast<char*>(data), size);
+	if (descriptor >= 0) close(descriptor);
+}
+
+#endif
+
+std::string_view utils::MappedFile::getData() const
+{
+	return {data, size};
+}
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace utils
+{
+	//	read-only view of a whole file mapped into the address space of the process
+	class MappedFile
+	{
+		public:
+			explicit MappedFile(const std::string& path);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			std::string_view getData() const;
+
+		private:
+			const char* data;
+			std::size_t size;
+
+#ifdef _WIN32
+			void* file;
+			void* mapping;
+#else
+			int descriptor;
+#endif
+	};
+}
+
+#endif
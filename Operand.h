@@ -19,6 +19,9 @@ namespace token::operand
 			virtual std::optional<std::string_view> parse(std::string_view expression, Context& context) = 0;
 			virtual Type getValue() const = 0;
 			virtual std::string toString() const = 0;
+
+			//	a Currency keeps its arithmetic exact, and a virtual call tells it apart more cheaply than a cast
+			virtual bool isCurrency() const { return false; }
 	};
 
 	using Ptr = std::shared_ptr<Operand>;
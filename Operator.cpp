@@ -2,14 +2,22 @@
 
 #include "Utils.h"
 #include "Boolean.h"
+#include "Currency.h"
 #include "Float.h"
 #include "Integer.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <cmath>
 #include <vector>
 #include <utility>
 #include <cinttypes>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 
 namespace
 {
@@ -59,6 +67,296 @@ namespace
 
 	constexpr token::Operator UnaryPlus {token::Operator::Positive, 3, 1};
 	constexpr token::Operator UnaryMinus {token::Operator::Negative, 3, 1};
+
+	//	squares and products of integers below 2^53 are correctly rounded, so they give std::pow's result to the last
+	//	bit; every other case is left to std::pow (a reciprocal too, whose NaN keeps a sign std::pow may not)
+	double integerPower(double base, long long exponent)
+	{
+		if (exponent == 2)
+			return base * base;
+
+		return std::pow(base, static_cast<double>(exponent));
+	}
+
+	double integerPower(long long base, long long exponent)
+	{
+		constexpr auto Exact = 9007199254740992.0;
+
+		auto result = 1.0, factor = static_cast<double>(base);
+
+		for (auto remaining = exponent; remaining > 0 && std::abs(factor) <= Exact; factor *= factor) {
+			if (remaining & 1)
+				result *= factor;
+
+			if (std::abs(result) > Exact)
+				break;
+			if ((remaining >>= 1) == 0)
+				return result;
+		}
+
+		return exponent == 0 ? 1.0 : integerPower(static_cast<double>(base), exponent);
+	}
+
+	//	the unary math functions, whose Float result depends on nothing but the bits of the argument
+	double math(token::Operator::Type type, double x)
+	{
+		switch (type)
+		{
+			case token::Operator::Acos:		return std::acos(x);
+			case token::Operator::Asin:		return std::asin(x);
+			case token::Operator::Atan:		return std::atan(x);
+			case token::Operator::Cos:		return std::cos(x);
+			case token::Operator::Sin:		return std::sin(x);
+			case token::Operator::Tan:		return std::tan(x);
+			case token::Operator::Exp:		return std::exp(x);
+			case token::Operator::Log:		return std::log(x);
+			case token::Operator::Log10:	return std::log10(x);
+			default:						return std::sqrt(x);
+		}
+	}
+
+	std::atomic<bool> Memoizing {false};
+
+	struct Memo
+	{
+		struct Entry
+		{
+			token::Operator::Type type;
+			std::uint64_t bits;
+			token::operand::Ptr result;
+		};
+
+		std::array<Entry, token::memo::Entries> entries {};
+		token::memo::Statistics statistics {};
+	};
+
+	Memo& threadMemo()
+	{
+		thread_local Memo memo;
+		return memo;
+	}
+
+	//	the result operand of an earlier call with the same bits, shared since operands are never modified, or a new one
+	token::operand::Ptr memoized(token::Operator::Type type, double argument)
+	{
+		auto bits = std::uint64_t(0);
+		std::memcpy(&bits, &argument, sizeof(bits));
+
+		auto& cache = threadMemo();
+		auto& entry = cache.entries[((bits ^ static_cast<std::uint64_t>(type)) * 0x9E3779B97F4A7C15ull >> 32) % token::memo::Entries];
+
+		if (entry.result && entry.type == type && entry.bits == bits) {
+			++cache.statistics.hits;
+			return entry.result;
+		}
+
+		++cache.statistics.misses;
+		entry = {type, bits, std::make_shared<token::operand::Float>(math(type, argument))};
+		return entry.result;
+	}
+
+	using token::operand::Currency;
+
+	constexpr auto MaxScaled = std::numeric_limits<long long>::max(), MinScaled = std::numeric_limits<long long>::min();
+
+	const Currency* asCurrency(const token::operand::Ptr& operand)
+	{
+		return operand->isCurrency() ? static_cast<const Currency*>(operand.get()) : nullptr;
+	}
+
+	[[noreturn]] void overflow()
+	{
+		throw std::runtime_error("Overflow");
+	}
+
+	std::uint64_t magnitudeOf(long long value)
+	{
+		return value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+	}
+
+	long long signedOf(std::uint64_t magnitude, bool negative)
+	{
+		if (magnitude > static_cast<std::uint64_t>(MaxScaled) + (negative ? 1 : 0))
+			overflow();
+
+		return negative ? static_cast<long long>(0 - magnitude) : static_cast<long long>(magnitude);
+	}
+
+	//	a * b / divisor, rounded half to even, through a 128-bit product built from 32-bit halves so it needs no compiler extension
+	long long scaledProduct(long long a, long long b, std::uint32_t divisor)
+	{
+		const auto x = magnitudeOf(a), y = magnitudeOf(b);
+		const auto low = [] (std::uint64_t v) { return v & 0xFFFFFFFFu; };
+
+		const auto ll = low(x) * low(y), lh = low(x) * (y >> 32), hl = (x >> 32) * low(y), hh = (x >> 32) * (y >> 32);
+		const auto middle = (ll >> 32) + low(lh) + low(hl);
+		const auto lo = low(ll) | middle << 32, hi = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+
+		std::uint64_t limbs[4] {hi >> 32, low(hi), lo >> 32, low(lo)};
+
+		//	long division a 32-bit limb at a time, from the most significant
+		auto remainder = std::uint64_t(0);
+		for (auto& limb : limbs) {
+			const auto dividend = remainder << 32 | limb;
+			limb = dividend / divisor;
+			remainder = dividend % divisor;
+		}
+
+		if (limbs[0] || limbs[1])
+			overflow();
+
+		auto quotient = limbs[2] << 32 | limbs[3];
+		if ((2 * remainder > divisor || (2 * remainder == divisor && quotient % 2)) && ++quotient == 0)
+			overflow();
+
+		return signedOf(quotient, (a < 0) != (b < 0) && quotient);
+	}
+
+	long long checkedSum(long long a, long long b)
+	{
+		if ((b > 0 && a > MaxScaled - b) || (b < 0 && a < MinScaled - b))
+			overflow();
+
+		return a + b;
+	}
+
+	//	an integer as a Currency, for the operations that promote it
+	long long toScaled(long long integer)
+	{
+		return scaledProduct(integer, Currency::Scale, 1);
+	}
+
+	//	-1, 0 or 1 as a Currency (in ten-thousandths) is less than, equal to or greater than an integer, for every integer
+	int compareToInteger(long long scaled, long long integer)
+	{
+		if (integer > MaxScaled / Currency::Scale)
+			return -1;
+		if (integer < MinScaled / Currency::Scale)
+			return 1;
+
+		const auto units = integer * Currency::Scale;
+		return scaled < units ? -1 : scaled > units;
+	}
+
+	long long roundedToInteger(long long scaled)
+	{
+		const auto quotient = scaled / Currency::Scale, remainder = scaled % Currency::Scale;
+		const auto twice = 2 * (remainder < 0 ? -remainder : remainder);
+
+		if (twice > Currency::Scale || (twice == Currency::Scale && quotient % 2))
+			return quotient + (remainder < 0 ? -1 : 1);
+		return quotient;
+	}
+
+	//	the operations on a Currency with an exact Currency or Integer result, or nothing for those computed on its Float value
+	token::operand::Ptr computeCurrency(token::Operator::Type type, long long scaled)
+	{
+		const auto quotient = scaled / Currency::Scale, remainder = scaled % Currency::Scale;
+
+		switch (type)
+		{
+			case token::Operator::Negative:
+				if (scaled == MinScaled)
+					overflow();
+				return std::make_unique<Currency>(-scaled);
+
+			case token::Operator::Abs:
+				if (scaled == MinScaled)
+					overflow();
+				return std::make_unique<Currency>(scaled < 0 ? -scaled : scaled);
+
+			case token::Operator::Ceil:
+				return std::make_unique<Currency>(scaledProduct(quotient + (remainder > 0 ? 1 : 0), Currency::Scale, 1));
+
+			case token::Operator::Floor:
+				return std::make_unique<Currency>(scaledProduct(quotient - (remainder < 0 ? 1 : 0), Currency::Scale, 1));
+
+			case token::Operator::Truncate:
+				return std::make_unique<Currency>(quotient * Currency::Scale);
+
+			case token::Operator::Round:
+				return std::make_unique<token::operand::Integer>(roundedToInteger(scaled));
+
+			case token::Operator::Not:
+				return std::make_unique<token::operand::Integer>(~roundedToInteger(scaled));
+
+			default:
+				return nullptr;
+		}
+	}
+
+	//	the operations with a Currency operand and another that is not a Float, or nothing for those that promote to a Float
+	token::operand::Ptr computeCurrency(token::Operator::Type type, const token::operand::Ptr& leftOperand, const token::operand::Ptr& rightOperand)
+	{
+		struct Exact
+		{
+			long long value;
+			bool currency;
+		};
+
+		const auto exactOf = [] (const token::operand::Ptr& operand) -> std::optional<Exact> {
+			if (const auto currency = asCurrency(operand))
+				return Exact {currency->getScaled(), true};
+
+			const auto value = operand->getValue();
+			if (const auto integer = std::get_if<long long>(&value))
+				return Exact {*integer, false};
+			return {};
+		};
+
+		const auto left = exactOf(leftOperand), right = exactOf(rightOperand);
+		if (!left || !right)
+			return nullptr;
+
+		const auto scaledOf = [] (const Exact& operand) { return operand.currency ? operand.value : toScaled(operand.value); };
+
+		const auto compared = [&left, &right] {
+			if (left->currency && right->currency)
+				return left->value < right->value ? -1 : left->value > right->value;
+			return left->currency ? compareToInteger(left->value, right->value) : -compareToInteger(right->value, left->value);
+		};
+
+		switch (type)
+		{
+			case token::Operator::Sum:
+				return std::make_unique<Currency>(checkedSum(scaledOf(*left), scaledOf(*right)));
+
+			case token::Operator::Difference: {
+				const auto subtrahend = scaledOf(*right);
+				if (subtrahend == MinScaled)
+					overflow();
+				return std::make_unique<Currency>(checkedSum(scaledOf(*left), -subtrahend));
+			}
+
+			case token::Operator::Multiplication:
+				if (left->currency && right->currency)
+					return std::make_unique<Currency>(scaledProduct(left->value, right->value, Currency::Scale));
+				return std::make_unique<Currency>(scaledProduct(left->value, right->value, 1));
+
+			//	the remainder has the sign of the dividend, and an integer too large for a Currency is larger than any dividend
+			case token::Operator::Mod: {
+				if (!right->currency && (right->value > MaxScaled / Currency::Scale || right->value < MinScaled / Currency::Scale))
+					return std::make_unique<Currency>(scaledOf(*left));
+
+				const auto divisor = scaledOf(*right);
+				if (divisor == 0)
+					throw std::runtime_error("Division by zero");
+
+				const auto dividend = scaledOf(*left);
+				return std::make_unique<Currency>(divisor == -1 ? 0 : dividend % divisor);
+			}
+
+			case token::Operator::Equality:			return std::make_unique<token::operand::Boolean>(compared() == 0);
+			case token::Operator::Inequality:		return std::make_unique<token::operand::Boolean>(compared() != 0);
+			case token::Operator::LessThan:			return std::make_unique<token::operand::Boolean>(compared() < 0);
+			case token::Operator::LessThanEqual:	return std::make_unique<token::operand::Boolean>(compared() <= 0);
+			case token::Operator::GreaterThan:		return std::make_unique<token::operand::Boolean>(compared() > 0);
+			case token::Operator::GreaterThanEqual:	return std::make_unique<token::operand::Boolean>(compared() >= 0);
+
+			default:
+				return nullptr;
+		}
+	}
 }
 
 std::optional<std::string_view> token::Operator::parse(std::string_view expression, Context& context)
@@ -68,7 +366,7 @@ std::optional<std::string_view> token::Operator::parse(std::string_view expressi
 
 	auto [prefix, op] = found.value();
 
-	if (prefix.length() > 1 && utils::str::charAfterPrefix(expression, prefix, [] (char ch) { return !utils::contains("\n\v\f\r\t(+- ", ch); } ))
+	if (prefix.length() > 1 && utils::str::charAfterPrefix(expression, prefix, [] (char ch) { return !utils::str::isClass(ch, utils::str::Space) && !utils::contains("(+-", ch); } ))
 		return {};
 
 	if (context.lastToken == Context::TokenType::Operator) {
@@ -93,6 +391,10 @@ std::optional<std::string_view> token::Operator::parse(std::string_view expressi
 
 token::operand::Ptr token::Operator::compute(token::operand::Ptr operand)
 {
+	if (const auto currency = asCurrency(operand))
+		if (auto result = computeCurrency(type, currency->getScaled()))
+			return result;
+
 	switch (type)
 	{
 		case token::Operator::Positive:
@@ -127,64 +429,21 @@ token::operand::Ptr token::Operator::compute(token::operand::Ptr operand)
 			}, operand->getValue());
 		}
 
-		case token::Operator::Acos: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::acos(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Asin: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::asin(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Atan: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::atan(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Cos: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::cos(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Sin: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::sin(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Tan: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::tan(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Exp: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::exp(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Log: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::log(val));
-			}, operand->getValue());
-		}
-
-		case token::Operator::Log10: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::log10(val));
-			}, operand->getValue());
-		}
-
+		case token::Operator::Acos:
+		case token::Operator::Asin:
+		case token::Operator::Atan:
+		case token::Operator::Cos:
+		case token::Operator::Sin:
+		case token::Operator::Tan:
+		case token::Operator::Exp:
+		case token::Operator::Log:
+		case token::Operator::Log10:
 		case token::Operator::Sqrt: {
-			return std::visit([] (auto&& val) {
-				return std::make_unique<token::operand::Float>(std::sqrt(val));
-			}, operand->getValue());
+			const auto argument = std::visit([] (auto&& val) { return static_cast<double>(val); }, operand->getValue());
+
+			if (Memoizing.load(std::memory_order_relaxed))
+				return memoized(type, argument);
+			return std::make_unique<token::operand::Float>(math(type, argument));
 		}
 
 		case token::Operator::Ceil: {
@@ -215,6 +474,10 @@ token::operand::Ptr token::Operator::compute(token::operand::Ptr operand)
 
 token::operand::Ptr token::Operator::compute(token::operand::Ptr leftOperand, token::operand::Ptr rightOperand)
 {
+	if (asCurrency(leftOperand) || asCurrency(rightOperand))
+		if (auto result = computeCurrency(type, leftOperand, rightOperand))
+			return result;
+
 	switch (type)
 	{
 		case token::Operator::Power: {
@@ -226,6 +489,20 @@ token::operand::Ptr token::Operator::compute(token::operand::Ptr leftOperand, to
 
 			return std::make_unique<token::operand::Float>(result);
 		}
+
+		case token::Operator::IntegerPower: {
+			const auto exponent = rightOperand->getValue();
+
+			if (const auto integer = std::get_if<long long>(&exponent)) {
+				auto result = std::visit([integer] (auto&& val_l) {
+					return integerPower(val_l, *integer);
+				}, leftOperand->getValue());
+
+				return std::make_unique<token::operand::Float>(result);
+			}
+
+			return Operator {Power, precedence, arity}.compute(std::move(leftOperand), std::move(rightOperand));
+		}
 			
 		case token::Operator::Multiplication: {
 			return std::visit([&rightOperand] (auto&& val_l) -> token::operand::Ptr {
@@ -464,3 +741,23 @@ token::operand::Ptr token::Operator::compute(token::operand::Ptr leftOperand, to
 		}
 	}
 }
+
+void token::memo::enable(bool enabled)
+{
+	Memoizing.store(enabled, std::memory_order_relaxed);
+}
+
+bool token::memo::isEnabled()
+{
+	return Memoizing.load(std::memory_order_relaxed);
+}
+
+token::memo::Statistics token::memo::statistics()
+{
+	return threadMemo().statistics;
+}
+
+void token::memo::clear()
+{
+	threadMemo() = {};
+}
@@ -4,6 +4,8 @@
 #include "Context.h"
 #include "Operand.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string_view>
 
@@ -53,6 +55,7 @@ namespace token
 			Sqrt,
 			Tan,
 			Truncate,
+			IntegerPower,	//	Power with a small constant integer exponent, only emitted by the compiler
 			Total
 		};
  
@@ -64,6 +67,27 @@ namespace token
 		Type type;
 		int precedence, arity;
 	};
+
+	//	memo of the unary math functions (Acos, Asin, Atan, Cos, Exp, Log, Log10, Sin, Sqrt, Tan) for calls repeated
+	//	across evaluations: direct-mapped on the function and the exact bits of its argument, so a hit gives the same
+	//	result bit for bit, and kept per thread with at most 'Entries' results; off until enabled
+	namespace memo
+	{
+		constexpr std::size_t Entries = 1024;
+
+		struct Statistics
+		{
+			std::uint64_t hits, misses;
+		};
+
+		//	for every thread
+		void enable(bool enabled);
+		bool isEnabled();
+
+		//	of the calling thread
+		Statistics statistics();
+		void clear();
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "Registry.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+compiled::Registry::Version::Version(Formulas formulas, std::uint64_t number)
+	:
+	formulas(std::move(formulas)),
+	number(number)
+{
+	std::sort(std::begin(this->formulas), std::end(this->formulas), [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+	const auto twice = std::adjacent_find(std::begin(this->formulas), std::end(this->formulas), [] (const auto& a, const auto& b) { return a.first == b.first; });
+	if (twice != std::end(this->formulas))
+		throw std::runtime_error("Formula '" + twice->first + "' registered twice");
+}
+
+const compiled::Expression* compiled::Registry::Version::find(std::string_view name) const
+{
+	const auto found = std::lower_bound(std::begin(formulas), std::end(formulas), name, [] (const auto& formula, std::string_view name) { return formula.first < name; });
+	return found != std::end(formulas) && found->first == name ? &found->second : nullptr;
+}
+
+std::size_t compiled::Registry::Version::size() const
+{
+	return formulas.size();
+}
+
+std::uint64_t compiled::Registry::Version::getNumber() const
+{
+	return number;
+}
+
+compiled::Registry::Reader::Reader(Registry& registry)
+	:
+	registry(registry),
+	slot(registry.acquireSlot())
+{ }
+
+compiled::Registry::Reader::~Reader()
+{
+	registry.releaseSlot(slot);
+}
+
+//	the epoch is announced before the version is read: a writer that sees the slot empty, or in an epoch no earlier
+//	than the one it retired a version in, has exchanged the version before this load, which can only return a later one
+compiled::Registry::Snapshot::Snapshot(Reader& reader)
+	:
+	reader(reader)
+{
+	reader.slot.epoch.store(reader.registry.epoch.load());
+	version = reader.registry.current.load();
+}
+
+compiled::Registry::Snapshot::~Snapshot()
+{
+	reader.slot.epoch.store(0, std::memory_order_release);
+}
+
+compiled::Registry::Registry()
+	:
+	current(new Version({}, 0)),
+	epoch(1),
+	published(0)
+{ }
+
+compiled::Registry::~Registry()
+{
+	delete current.load();
+}
+
+std::uint64_t compiled::Registry::publish(Formulas formulas)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto next = std::make_unique<const Version>(std::move(formulas), published + 1);
+	++published;
+
+	const auto previous = current.exchange(next.release());
+	retired.push_back({std::unique_ptr<const Version>(previous), epoch.fetch_add(1) + 1});
+	reclaimLocked();
+
+	return published;
+}
+
+std::uint64_t compiled::Registry::publish(const std::vector<std::pair<std::string, std::string>>& sources)
+{
+	Formulas formulas;
+	formulas.reserve(sources.size());
+
+	for (const auto& [name, expression] : sources)
+	{
+		try
+		{
+			formulas.emplace_back(name, Expression::compile(expression));
+		}
+		catch (const std::exception& error)
+		{
+			throw std::runtime_error("Formula '" + name + "': " + error.what());
+		}
+	}
+
+	return publish(std::move(formulas));
+}
+
+std::size_t compiled::Registry::reclaim()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return reclaimLocked();
+}
+
+compiled::Registry::Slot& compiled::Registry::acquireSlot()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	const auto free = std::find_if(std::begin(slots), std::end(slots), [] (const auto& slot) { return !slot->used; });
+	auto& slot = free != std::end(slots) ? **free : *slots.emplace_back(std::make_unique<Slot>());
+
+	slot.used = true;
+	return slot;
+}
+
+void compiled::Registry::releaseSlot(Slot& slot)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	slot.used = false;
+}
+
+std::size_t compiled::Registry::reclaimLocked()
+{
+	auto oldest = std::numeric_limits<std::uint64_t>::max();
+	for (const auto& slot : slots)
+		if (const auto announced = slot->epoch.load(); announced != 0)
+			oldest = std::min(oldest, announced);
+
+	retired.erase(std::remove_if(std::begin(retired), std::end(retired), [oldest] (const Retired& entry) { return entry.epoch <= oldest; }), std::end(retired));
+	return retired.size();
+}
@@ -0,0 +1,132 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include "Expression.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace compiled
+{
+	//	named formulas ("pricing.v3") shared by every evaluating thread, replaced as a whole set while they evaluate
+	//
+	//	the set is read-copy-update: a writer compiles a new version, publishes it with a single atomic exchange and
+	//	retires the old one, which is freed once no reader can still see it. Readers announce the epoch they read in
+	//	and never wait for a writer or for each other; writers are serialized among themselves
+	class Registry
+	{
+		struct Slot;
+
+		public:
+			using Formulas = std::vector<std::pair<std::string, Expression>>;
+
+			//	one set of formulas, never modified once published
+			class Version
+			{
+				public:
+					//	throws on a name given twice
+					Version(Formulas formulas, std::uint64_t number);
+
+					//	the formula registered under 'name', or nullptr
+					const Expression* find(std::string_view name) const;
+
+					std::size_t size() const;
+
+					//	1 for the first version published, 0 for the empty one a registry starts with
+					std::uint64_t getNumber() const;
+
+				private:
+					Formulas formulas;		//	sorted by name
+					std::uint64_t number;
+			};
+
+			class Snapshot;
+
+			//	the handle of one reading thread, which may keep at most one Snapshot at a time
+			class Reader
+			{
+				public:
+					explicit Reader(Registry& registry);
+					~Reader();
+
+					Reader(const Reader&) = delete;
+					Reader& operator=(const Reader&) = delete;
+
+				private:
+					friend class Snapshot;
+
+					Registry& registry;
+					Slot& slot;
+			};
+
+			//	the version current when it was taken, which stays valid (even once replaced) until the snapshot goes away
+			class Snapshot
+			{
+				public:
+					explicit Snapshot(Reader& reader);
+					~Snapshot();
+
+					Snapshot(const Snapshot&) = delete;
+					Snapshot& operator=(const Snapshot&) = delete;
+
+					const Version& operator*() const { return *version; }
+					const Version* operator->() const { return version; }
+
+				private:
+					Reader& reader;
+					const Version* version;
+			};
+
+			Registry();
+
+			//	every Reader must be gone
+			~Registry();
+
+			Registry(const Registry&) = delete;
+			Registry& operator=(const Registry&) = delete;
+
+			//	replaces the whole set, then frees the versions no reader can still see, and returns the new version number
+			std::uint64_t publish(Formulas formulas);
+
+			//	compiles every (name, expression) pair and publishes them, leaving the current version in place on any error
+			std::uint64_t publish(const std::vector<std::pair<std::string, std::string>>& sources);
+
+			//	frees the retired versions no reader can still see, and returns how many are still waiting on a reader
+			std::size_t reclaim();
+
+		private:
+			//	a reader's epoch on a cache line of its own, 0 while it holds no snapshot
+			struct alignas(64) Slot
+			{
+				std::atomic<std::uint64_t> epoch{0};
+				bool used = false;
+			};
+
+			struct Retired
+			{
+				std::unique_ptr<const Version> version;
+				std::uint64_t epoch;		//	readers in an earlier epoch may still see the version
+			};
+
+			Slot& acquireSlot();
+			void releaseSlot(Slot& slot);
+			std::size_t reclaimLocked();
+
+			std::atomic<const Version*> current;
+			std::atomic<std::uint64_t> epoch;
+
+			std::mutex mutex;								//	writers, and readers registering or leaving
+			std::vector<std::unique_ptr<Slot>> slots;		//	never shrinks, so a reader's slot stays where it is
+			std::vector<Retired> retired;
+			std::uint64_t published;
+	};
+}
+
+#endif
@@ -0,0 +1,344 @@
+#include "Serialization.h"
+
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Integer.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+	using utils::bytes::load32;
+	using utils::bytes::load64;
+	using utils::bytes::store32;
+	using utils::bytes::store64;
+
+	constexpr char Magic[4] {'V', 'B', 'A', 'E'};
+
+	constexpr std::size_t HeaderSize = 32;
+	constexpr std::size_t EntrySize = 24;
+	constexpr std::size_t SymbolSize = 8;
+	constexpr std::size_t InstructionSize = 16;
+	constexpr std::size_t ChecksumStart = 12;
+
+	enum class Opcode : std::uint8_t { Boolean, Integer, Float, Variable, Operation, Currency };
+
+	std::uint32_t checksum(std::string_view bytes)
+	{
+		auto hash = 2166136261u;
+		for (const auto byte : bytes)
+			hash = (hash ^ static_cast<unsigned char>(byte)) * 16777619u;
+
+		return hash;
+	}
+
+	//	offsets of the sections of an image, derived from the counts in its header
+	struct Layout
+	{
+		explicit Layout(const char* image)
+			:
+			expressionCount(load32(image + 12)),
+			symbolCount(load32(image + 16)),
+			instructionCount(load32(image + 20)),
+			stringBytes(load32(image + 24)),
+			entries(HeaderSize),
+			symbols(entries + EntrySize * expressionCount),
+			instructions(symbols + SymbolSize * symbolCount),
+			strings(instructions + InstructionSize * instructionCount)
+		{ }
+
+		std::uint64_t expressionCount, symbolCount, instructionCount, stringBytes;
+		std::uint64_t entries, symbols, instructions, strings;
+	};
+
+	std::string_view loadString(const char* image, const char* reference)
+	{
+		return {image + Layout(image).strings + load32(reference), load32(reference + 4)};
+	}
+
+	bool isUnary(token::Operator::Type type)
+	{
+		return type == token::Operator::Positive || type == token::Operator::Negative || type == token::Operator::Not
+			|| (type >= token::Operator::Abs && type <= token::Operator::Truncate);
+	}
+
+	//	IntegerPower only from version 2, which added it
+	bool isBinary(token::Operator::Type type, std::uint32_t version)
+	{
+		return (type >= token::Operator::Power && type < token::Operator::Abs && !isUnary(type)) || (type == token::Operator::IntegerPower && version >= 2);
+	}
+}
+
+std::string serialized::write(const std::vector<std::pair<std::string, compiled::Expression>>& expressions)
+{
+	std::vector<std::size_t> order(expressions.size());
+	std::iota(std::begin(order), std::end(order), 0);
+	std::stable_sort(std::begin(order), std::end(order), [&expressions] (std::size_t lhs, std::size_t rhs) { return expressions[lhs].first < expressions[rhs].first; });
+
+	std::string entries, symbols, instructions, strings;
+	auto symbolCount = 0u, instructionCount = 0u;
+
+	const auto storeString = [&strings] (std::string& section, std::string_view str) {
+		store32(section, static_cast<std::uint32_t>(strings.size()));
+		store32(section, static_cast<std::uint32_t>(str.size()));
+		strings += str;
+	};
+
+	for (const auto index : order)
+	{
+		const auto& [name, expression] = expressions[index];
+
+		storeString(entries, name);
+		store32(entries, symbolCount);
+		store32(entries, static_cast<std::uint32_t>(expression.getAliases().size()));
+		store32(entries, instructionCount);
+		store32(entries, static_cast<std::uint32_t>(expression.getInstructions().size()));
+
+		for (const auto& alias : expression.getAliases())
+			storeString(symbols, alias);
+
+		for (const auto& instruction : expression.getInstructions())
+		{
+			auto opcode = Opcode::Operation;
+			auto value = std::uint64_t(0);
+
+			if (instruction.code == compiled::Instruction::Code::Variable)
+				opcode = Opcode::Variable;
+			else if (instruction.code == compiled::Instruction::Code::Constant) {
+				const auto constant = instruction.constant->getValue();
+
+				if (const auto currency = dynamic_cast<const token::operand::Currency*>(instruction.constant.get())) {
+					opcode = Opcode::Currency;
+					value = static_cast<std::uint64_t>(currency->getScaled());
+				}
+				else if (const auto integer = std::get_if<long long>(&constant)) {
+					opcode = dynamic_cast<const token::operand::Boolean*>(instruction.constant.get()) ? Opcode::Boolean : Opcode::Integer;
+					value = static_cast<std::uint64_t>(*integer);
+				}
+				else {
+					opcode = Opcode::Float;
+					std::memcpy(&value, &std::get<double>(constant), sizeof(value));
+				}
+			}
+
+			instructions.push_back(static_cast<char>(opcode));
+			instructions.push_back(static_cast<char>(instruction.operation.type));
+			instructions.push_back(static_cast<char>(instruction.operation.precedence));
+			instructions.push_back(static_cast<char>(instruction.operation.arity));
+			store32(instructions, static_cast<std::uint32_t>(instruction.slot));
+			store64(instructions, value);
+		}
+
+		symbolCount += static_cast<std::uint32_t>(expression.getAliases().size());
+		instructionCount += static_cast<std::uint32_t>(expression.getInstructions().size());
+	}
+
+	std::string image(std::begin(Magic), std::end(Magic));
+	store32(image, Version);
+	store32(image, 0);
+	store32(image, static_cast<std::uint32_t>(expressions.size()));
+	store32(image, symbolCount);
+	store32(image, instructionCount);
+	store32(image, static_cast<std::uint32_t>(strings.size()));
+	store32(image, 0);
+
+	image += entries;
+	image += symbols;
+	image += instructions;
+	image += strings;
+
+	const auto sum = checksum(std::string_view(image).substr(ChecksumStart));
+	for (auto byte = 0; byte < 4; ++byte)
+		image[8 + byte] = static_cast<char>(sum >> (8 * byte) & 0xFF);
+
+	return image;
+}
+
+serialized::ExpressionView::ExpressionView(const char* image, const char* entry)
+	:
+	image(image),
+	entry(entry)
+{ }
+
+std::string_view serialized::ExpressionView::getName() const
+{
+	return loadString(image, entry);
+}
+
+std::size_t serialized::ExpressionView::getSlotCount() const
+{
+	return load32(entry + 12);
+}
+
+std::string_view serialized::ExpressionView::getAlias(std::size_t slot) const
+{
+	const Layout layout(image);
+	return loadString(image, image + layout.symbols + (load32(entry + 8) + slot) * SymbolSize);
+}
+
+std::optional<std::size_t> serialized::ExpressionView::slotOf(std::string_view alias) const
+{
+	for (auto slot = std::size_t(0); slot < getSlotCount(); ++slot)
+		if (getAlias(slot) == alias)
+			return slot;
+
+	return {};
+}
+
+compiled::Bindings serialized::ExpressionView::bind(const std::vector<token::Variable>& vars) const
+{
+	compiled::Bindings bindings(getSlotCount());
+
+	for (auto slot = std::size_t(0); slot < bindings.size(); ++slot)
+	{
+		const auto alias = getAlias(slot);
+		const auto found = std::find_if(std::begin(vars), std::end(vars), [alias] (const token::Variable& var) { return alias == var.alias; });
+
+		if (found != std::end(vars))
+			bindings[slot] = found->operand;
+	}
+
+	return bindings;
+}
+
+token::operand::Ptr serialized::ExpressionView::evaluate(const compiled::Bindings& bindings) const
+{
+	const Layout layout(image);
+	const auto count = load32(entry + 20);
+	auto instruction = image + layout.instructions + load32(entry + 16) * InstructionSize;
+
+	std::vector<token::operand::Ptr> operands;
+	operands.reserve(count);
+
+	for (auto i = 0u; i < count; ++i, instruction += InstructionSize)
+	{
+		const auto bytes = reinterpret_cast<const unsigned char*>(instruction);
+
+		switch (static_cast<Opcode>(bytes[0]))
+		{
+			case Opcode::Boolean:
+				operands.push_back(std::make_shared<token::operand::Boolean>(load64(instruction + 8) != 0));
+				break;
+
+			case Opcode::Integer:
+				operands.push_back(std::make_shared<token::operand::Integer>(static_cast<long long>(load64(instruction + 8))));
+				break;
+
+			case Opcode::Float: {
+				const auto bits = load64(instruction + 8);
+				auto value = 0.0;
+				std::memcpy(&value, &bits, sizeof(value));
+
+				operands.push_back(std::make_shared<token::operand::Float>(value));
+				break;
+			}
+
+			case Opcode::Currency:
+				operands.push_back(std::make_shared<token::operand::Currency>(static_cast<long long>(load64(instruction + 8))));
+				break;
+
+			case Opcode::Variable:
+				if (const auto slot = load32(instruction + 4); slot < bindings.size() && bindings[slot])
+					operands.push_back(bindings[slot]);
+				break;
+
+			case Opcode::Operation:
+				compiled::apply({static_cast<token::Operator::Type>(bytes[1]), bytes[2], bytes[3]}, operands);
+				break;
+		}
+	}
+
+	if (operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	return operands.back();
+}
+
+serialized::Catalogue::Catalogue(std::string_view image, bool verifyChecksum)
+	:
+	image(image),
+	expressionCount(0)
+{
+	if (image.size() < HeaderSize || image.compare(0, sizeof(Magic), Magic, sizeof(Magic)) != 0)
+		throw std::runtime_error("Not an expression catalogue");
+
+	const auto version = load32(image.data() + 4);
+	if (version == 0 || version > Version)
+		throw std::runtime_error("Unsupported catalogue version " + std::to_string(version));
+
+	const Layout layout(image.data());
+
+	if (layout.strings + layout.stringBytes != image.size())
+		throw std::runtime_error("Truncated catalogue");
+
+	if (verifyChecksum && checksum(image.substr(ChecksumStart)) != load32(image.data() + 8))
+		throw std::runtime_error("Catalogue checksum mismatch");
+
+	const auto validString = [&layout] (const char* reference) {
+		return std::uint64_t(load32(reference)) + load32(reference + 4) <= layout.stringBytes;
+	};
+
+	for (auto symbol = std::uint64_t(0); symbol < layout.symbolCount; ++symbol)
+		if (!validString(image.data() + layout.symbols + symbol * SymbolSize))
+			throw std::runtime_error("Corrupted catalogue symbol");
+
+	for (auto index = std::uint64_t(0); index < layout.expressionCount; ++index)
+	{
+		const auto entry = image.data() + layout.entries + index * EntrySize;
+		const std::uint64_t firstSymbol = load32(entry + 8), symbolCount = load32(entry + 12);
+		const std::uint64_t firstInstruction = load32(entry + 16), instructionCount = load32(entry + 20);
+
+		if (!validString(entry) || firstSymbol + symbolCount > layout.symbolCount || firstInstruction + instructionCount > layout.instructionCount)
+			throw std::runtime_error("Corrupted catalogue entry");
+
+		for (auto i = firstInstruction; i < firstInstruction + instructionCount; ++i)
+		{
+			const auto instruction = image.data() + layout.instructions + i * InstructionSize;
+			const auto bytes = reinterpret_cast<const unsigned char*>(instruction);
+			const auto type = static_cast<token::Operator::Type>(bytes[1]);
+
+			const auto valid = bytes[0] < static_cast<unsigned char>(Opcode::Variable)
+				|| (bytes[0] == static_cast<unsigned char>(Opcode::Currency) && version >= 3)
+				|| (bytes[0] == static_cast<unsigned char>(Opcode::Variable) && load32(instruction + 4) < symbolCount)
+				|| (bytes[0] == static_cast<unsigned char>(Opcode::Operation) && ((bytes[3] == 1 && isUnary(type)) || (bytes[3] == 2 && isBinary(type, version))));
+
+			if (!valid)
+				throw std::runtime_error("Corrupted catalogue instruction");
+		}
+	}
+
+	expressionCount = static_cast<std::size_t>(layout.expressionCount);
+}
+
+std::size_t serialized::Catalogue::size() const
+{
+	return expressionCount;
+}
+
+serialized::ExpressionView serialized::Catalogue::operator[](std::size_t index) const
+{
+	return {image.data(), image.data() + HeaderSize + index * EntrySize};
+}
+
+std::optional<serialized::ExpressionView> serialized::Catalogue::find(std::string_view name) const
+{
+	auto first = std::size_t(0), last = expressionCount;
+
+	while (first < last) {
+		const auto middle = first + (last - first) / 2;
+
+		if ((*this)[middle].getName() < name)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	if (first < expressionCount && (*this)[first].getName() == name)
+		return (*this)[first];
+	return {};
+}
@@ -0,0 +1,69 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include "Expression.h"
+#include "Variable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//	Catalogue image layout, every integer little-endian and every reference an offset from the start of the image:
+//
+//		header			magic "VBAE", version, checksum, expression/symbol/instruction counts, string bytes, reserved
+//		entries			name, first symbol, symbol count, first instruction, instruction count (sorted by name)
+//		symbols			offset and length of each variable alias in the string table
+//		instructions	opcode, operator type, precedence, arity, slot, 64-bit constant
+//		strings			names and aliases, not null-terminated
+//
+//	the checksum is FNV-1a over everything that follows it
+
+namespace serialized
+{
+	//	version 2 added the IntegerPower operation and version 3 Currency constants; images of earlier versions remain readable
+	constexpr std::uint32_t Version = 3;
+
+	//	encodes the named expressions into a single catalogue image
+	std::string write(const std::vector<std::pair<std::string, compiled::Expression>>& expressions);
+
+	//	compiled expression evaluated directly from the bytes of a catalogue image
+	class ExpressionView
+	{
+		public:
+			ExpressionView(const char* image, const char* entry);
+
+			std::string_view getName() const;
+			std::size_t getSlotCount() const;
+			std::string_view getAlias(std::size_t slot) const;
+			std::optional<std::size_t> slotOf(std::string_view alias) const;
+
+			compiled::Bindings bind(const std::vector<token::Variable>& vars) const;
+			token::operand::Ptr evaluate(const compiled::Bindings& bindings) const;
+
+		private:
+			const char* image;
+			const char* entry;
+	};
+
+	//	read-only catalogue over an image that must outlive it, such as a utils::MappedFile
+	class Catalogue
+	{
+		public:
+			//	validates the header, the bounds of every record and, unless told otherwise, the checksum
+			explicit Catalogue(std::string_view image, bool verifyChecksum = true);
+
+			std::size_t size() const;
+			ExpressionView operator[](std::size_t index) const;
+			std::optional<ExpressionView> find(std::string_view name) const;
+
+		private:
+			std::string_view image;
+			std::size_t expressionCount;
+	};
+}
+
+#endif
@@ -0,0 +1,663 @@
+#include "Server.h"
+
+#include "Expression.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t ReadSize = 1 << 16;
+
+	//	state owned by a single worker thread: statements compiled once and reused across requests
+	class Evaluator
+	{
+		public:
+			Evaluator(std::size_t cacheSize, const compiled::Limits& limits) : cacheSize(std::max<std::size_t>(cacheSize, 1)), limits(limits)
+			{ }
+
+			//	returns false with the error text in 'result' when evaluation fails
+			bool evaluate(const std::string& expression, std::string& result)
+			{
+				try {
+					compiled::Budget budget(limits);
+					budget.checkLength(expression.size());
+
+					//	functions defined in the preamble are inlined into the program, so they are part of its key
+					const auto separator = expression.find(';');
+					const auto defines = separator != std::string::npos && expression.find('(') < separator;
+					auto statement = separator == std::string::npos || defines ? expression : expression.substr(separator + 1);
+
+					if (const auto found = index.find(statement); found != std::end(index))
+						entries.splice(std::begin(entries), entries, found->second);
+					else {
+						auto compiledStatement = compiled::Expression::compile(expression, budget);
+
+						//	the statement used least recently makes room for the new one
+						if (entries.size() >= cacheSize) {
+							index.erase(entries.back().first);
+							entries.pop_back();
+						}
+
+						entries.emplace_front(std::move(statement), std::move(compiledStatement));
+						index.emplace(entries.front().first, std::begin(entries));
+					}
+
+					const auto& statementCompiled = entries.front().second;
+					result = statementCompiled.evaluate(statementCompiled.bind(compiled::parseVariables(expression)), budget)->toString();
+					return true;
+				}
+				catch (const std::exception& e) {
+					result = "Error(s):\n\n" + std::string(e.what()) + "\n";
+					return false;
+				}
+			}
+
+		private:
+			//	the compiled statements, most recently used first, and where each one is in the list
+			std::list<std::pair<std::string, compiled::Expression>> entries;
+			std::unordered_map<std::string_view, std::list<std::pair<std::string, compiled::Expression>>::iterator> index;
+			std::size_t cacheSize;
+			compiled::Limits limits;
+	};
+}
+
+server::Options::Options()
+	:
+	threads(std::max(1u, std::thread::hardware_concurrency())),
+	cacheSize(1024),
+	maxFrame(1 << 20),
+	maxOutput(1 << 22)
+{ }
+
+#ifdef __linux__
+
+namespace
+{
+	//	closes its socket when it goes away
+	struct Connection
+	{
+		explicit Connection(int descriptor) : descriptor(descriptor)
+		{ }
+
+		~Connection()
+		{
+			close(descriptor);
+		}
+
+		Connection(const Connection&) = delete;
+		Connection& operator=(const Connection&) = delete;
+
+		int descriptor;
+		std::string input, output;
+		std::size_t written = 0;
+		std::uint32_t events = EPOLLIN;		//	what the poller watches the connection for
+
+		std::size_t pending() const
+		{
+			return output.size() - written;
+		}
+	};
+
+	//	watches for requests while the responses pending are under 'maxOutput', and for room to write while any is
+	//	pending, so a client that sends without reading stops being read; returns false if the poller refused
+	bool watch(int poller, Connection& connection, std::size_t maxOutput)
+	{
+		const auto events = (connection.pending() < maxOutput ? EPOLLIN : 0u) | (connection.pending() > 0 ? EPOLLOUT : 0u);
+		if (events == connection.events)
+			return true;
+
+		epoll_event event {};
+		event.events = events;
+		event.data.ptr = &connection;
+
+		if (epoll_ctl(poller, EPOLL_CTL_MOD, connection.descriptor, &event) != 0)
+			return false;
+
+		connection.events = events;
+		return true;
+	}
+
+	//	writes as much of the pending output as the socket takes; returns false if the connection broke
+	bool flush(Connection& connection)
+	{
+		while (connection.pending() > 0)
+		{
+			const auto sent = ::send(connection.descriptor, connection.output.data() + connection.written, connection.pending(), MSG_NOSIGNAL);
+			if (sent < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+					return false;
+
+				//	what was sent is dropped before more is appended, so the buffer holds little more than what's pending
+				if (connection.written >= ReadSize) {
+					connection.output.erase(0, connection.written);
+					connection.written = 0;
+				}
+				return true;
+			}
+
+			connection.written += static_cast<std::size_t>(sent);
+		}
+
+		connection.output.clear();
+		connection.written = 0;
+		return true;
+	}
+
+	//	evaluates the complete requests in the input buffer as one batch, until the responses pending reach
+	//	'maxOutput'; returns false on a malformed frame
+	bool process(Connection& connection, Evaluator& evaluator, std::size_t maxFrame, std::size_t maxOutput)
+	{
+		auto consumed = std::size_t(0);
+		std::string expression, result;
+
+		while (connection.input.size() - consumed >= 4 && connection.pending() < maxOutput)
+		{
+			const auto frame = connection.input.data() + consumed;
+			const auto length = utils::bytes::load32(frame);
+
+			if (length < 4 || length > maxFrame)
+				return false;
+			if (connection.input.size() - consumed - 4 < length)
+				break;
+
+			//	copied so that the parsers, which expect null-terminated text, never see the next frame
+			expression.assign(frame + 8, length - 4);
+			const auto succeeded = evaluator.evaluate(expression, result);
+
+			utils::bytes::store32(connection.output, static_cast<std::uint32_t>(5 + result.size()));
+			utils::bytes::store32(connection.output, utils::bytes::load32(frame + 4));
+			connection.output.push_back(succeeded ? 0 : 1);
+			connection.output += result;
+
+			consumed += 4 + length;
+		}
+
+		connection.input.erase(0, consumed);
+		return true;
+	}
+
+	//	answers the requests buffered and writes the responses, for as long as the socket takes them all; returns false
+	//	if the connection broke or sent a malformed frame
+	bool serve(int poller, Connection& connection, Evaluator& evaluator, const server::Options& options)
+	{
+		for (;;)
+		{
+			const auto buffered = connection.input.size();
+			const auto capped = connection.pending() >= options.maxOutput;
+
+			if (!process(connection, evaluator, options.maxFrame, options.maxOutput) || !flush(connection))
+				return false;
+
+			//	requests left behind by the cap are answered once the flush has drained what held them back, as nothing
+			//	pending any more brings an EPOLLOUT, and no EPOLLIN either once the client has sent them all
+			if (connection.pending() > 0 || (connection.input.size() == buffered && !capped))
+				return watch(poller, connection, options.maxOutput);
+		}
+	}
+
+	//	reads the socket into the input buffer until it's drained or holds the largest frame; returns false once the
+	//	peer has closed or the connection broke (the poller is level-triggered, so what's left is reported again)
+	bool receive(Connection& connection, std::size_t maxFrame)
+	{
+		char buffer[ReadSize];
+
+		while (connection.input.size() < 4 + maxFrame)
+		{
+			const auto received = ::recv(connection.descriptor, buffer, sizeof(buffer), 0);
+
+			if (received > 0)
+				connection.input.append(buffer, static_cast<std::size_t>(received));
+			else if (received == 0)
+				return false;
+			else if (errno == EINTR)
+				continue;
+			else
+				return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		return true;
+	}
+
+	sockaddr_un makeAddress(const std::string& path)
+	{
+		sockaddr_un address {};
+		address.sun_family = AF_UNIX;
+
+		if (path.size() >= sizeof(address.sun_path))
+			throw std::runtime_error("Socket path too long '" + path + "'");
+
+		std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+		return address;
+	}
+}
+
+server::Server::Server(const std::string& path, const Options& options)
+	:
+	path(path),
+	options(options),
+	listener(-1),
+	wakeup(-1),
+	stopping(false)
+{
+	const auto address = makeAddress(path);
+
+	listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listener < 0)
+		throw std::runtime_error("Cannot create socket");
+
+	unlink(path.c_str());
+
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+		close(listener);
+		throw std::runtime_error("Cannot listen on '" + path + "': " + std::strerror(errno));
+	}
+
+	wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeup < 0) {
+		close(listener);
+		throw std::runtime_error("Cannot create eventfd");
+	}
+}
+
+server::Server::~Server()
+{
+	close(wakeup);
+	close(listener);
+	unlink(path.c_str());
+}
+
+void server::Server::run()
+{
+	//	every poller is set up before a worker starts, so that a failure to set one up throws on the calling thread
+	std::vector<int> pollers;
+	const auto closePollers = [&pollers] {
+		for (const auto poller : pollers)
+			close(poller);
+	};
+
+	try {
+		for (auto i = 0u; i < std::max(options.threads, 1u); ++i)
+			pollers.push_back(createPoller());
+	}
+	catch (...) {
+		closePollers();
+		throw;
+	}
+
+	//	the first failure of a worker stops the others, and is rethrown once they have all returned
+	std::exception_ptr failure;
+	std::mutex failureMutex;
+
+	const auto fail = [this, &failure, &failureMutex] {
+		{
+			std::lock_guard<std::mutex> lock(failureMutex);
+			if (!failure)
+				failure = std::current_exception();
+		}
+		stop();
+	};
+
+	const auto serve = [this, &fail] (int poller) {
+		try {
+			work(poller);
+		}
+		catch (...) {
+			fail();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	try {
+		for (auto i = std::size_t(1); i < pollers.size(); ++i)
+			workers.emplace_back(serve, pollers[i]);
+	}
+	catch (...) {
+		fail();
+	}
+
+	serve(pollers.front());
+
+	for (auto& worker : workers)
+		worker.join();
+	closePollers();
+
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+void server::Server::stop()
+{
+	stopping = true;
+
+	const std::uint64_t signal = 1;
+	[[maybe_unused]] const auto written = write(wakeup, &signal, sizeof(signal));
+}
+
+//	a poller watching the listener and the wakeup event
+int server::Server::createPoller()
+{
+	const auto poller = epoll_create1(EPOLL_CLOEXEC);
+	if (poller < 0)
+		throw std::runtime_error(std::string("Cannot create epoll instance: ") + std::strerror(errno));
+
+	epoll_event listening {};
+	listening.events = EPOLLIN | EPOLLEXCLUSIVE;
+	listening.data.ptr = &listener;
+
+	epoll_event waking {};
+	waking.events = EPOLLIN;
+	waking.data.ptr = &wakeup;
+
+	if (epoll_ctl(poller, EPOLL_CTL_ADD, listener, &listening) != 0 || epoll_ctl(poller, EPOLL_CTL_ADD, wakeup, &waking) != 0) {
+		const auto error = errno;
+		close(poller);
+		throw std::runtime_error(std::string("Cannot watch the socket: ") + std::strerror(error));
+	}
+
+	return poller;
+}
+
+void server::Server::work(int poller)
+{
+	//	every worker has its own poller and accepts on the shared listener, so a connection stays on one thread
+	Evaluator evaluator(options.cacheSize, options.limits);
+	std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+
+	epoll_event events[64];
+
+	while (!stopping)
+	{
+		const auto ready = epoll_wait(poller, events, 64, -1);
+		if (ready < 0 && errno != EINTR)
+			throw std::runtime_error(std::string("Cannot wait for events: ") + std::strerror(errno));
+
+		for (auto i = 0; i < ready; ++i)
+		{
+			if (events[i].data.ptr == &wakeup)
+				continue;
+
+			if (events[i].data.ptr == &listener) {
+				for (int descriptor; (descriptor = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0; ) {
+					auto connection = std::make_unique<Connection>(descriptor);
+
+					epoll_event added {};
+					added.events = EPOLLIN;
+					added.data.ptr = connection.get();
+
+					//	a connection the poller refuses is closed at once
+					if (epoll_ctl(poller, EPOLL_CTL_ADD, descriptor, &added) == 0)
+						connections.emplace(connection.get(), std::move(connection));
+				}
+				continue;
+			}
+
+			const auto connection = static_cast<Connection*>(events[i].data.ptr);
+			auto open = true;
+
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+				open = receive(*connection, options.maxFrame);
+
+			if (open)
+				open = serve(poller, *connection, evaluator, options);
+
+			if (!open)
+				connections.erase(connection);
+		}
+	}
+}
+
+server::Client::Client(const std::string& path)
+	:
+	descriptor(-1),
+	consumed(0)
+{
+	const auto address = makeAddress(path);
+
+	descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (descriptor < 0 || connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		if (descriptor >= 0) close(descriptor);
+		throw std::runtime_error("Cannot connect to '" + path + "': " + std::strerror(errno));
+	}
+}
+
+server::Client::~Client()
+{
+	close(descriptor);
+}
+
+void server::Client::flush()
+{
+	for (auto written = std::size_t(0); written < output.size(); )
+	{
+		const auto sent = ::send(descriptor, output.data() + written, output.size() - written, MSG_NOSIGNAL);
+
+		if (sent < 0 && errno != EINTR)
+			throw std::runtime_error("Connection lost");
+		if (sent > 0)
+			written += static_cast<std::size_t>(sent);
+	}
+
+	output.clear();
+}
+
+server::Response server::Client::receive()
+{
+	while (!ready())
+	{
+		if (consumed > 0) {
+			input.erase(0, consumed);
+			consumed = 0;
+		}
+
+		char buffer[ReadSize];
+		const auto received = ::recv(descriptor, buffer, sizeof(buffer), 0);
+
+		if (received == 0 || (received < 0 && errno != EINTR))
+			throw std::runtime_error("Connection closed");
+		if (received > 0)
+			input.append(buffer, static_cast<std::size_t>(received));
+	}
+
+	const auto frame = input.data() + consumed;
+	const auto length = utils::bytes::load32(frame);
+
+	//	shorter than its id and status
+	if (length < 5)
+		throw std::runtime_error("Corrupted response");
+
+	consumed += 4 + length;
+
+	return {utils::bytes::load32(frame + 4), frame[8] != 0, std::string(frame + 9, length - 5)};
+}
+
+#else
+
+server::Server::Server(const std::string& path, const Options& options)
+	:
+	path(path),
+	options(options),
+	listener(-1),
+	wakeup(-1),
+	stopping(false)
+{
+	throw std::runtime_error("The evaluation server requires Linux");
+}
+
+server::Server::~Server()
+{ }
+
+void server::Server::run()
+{ }
+
+void server::Server::stop()
+{ }
+
+int server::Server::createPoller()
+{
+	return -1;
+}
+
+void server::Server::work(int)
+{ }
+
+server::Client::Client(const std::string& path)
+	:
+	descriptor(-1),
+	consumed(0)
+{
+	throw std::runtime_error("The evaluation server requires Linux");
+}
+
+server::Client::~Client()
+{ }
+
+void server::Client::flush()
+{ }
+
+server::Response server::Client::receive()
+{
+	return {};
+}
+
+#endif
+
+void server::Client::send(std::uint32_t id, std::string_view expression)
+{
+	utils::bytes::store32(output, static_cast<std::uint32_t>(4 + expression.size()));
+	utils::bytes::store32(output, id);
+	output += expression;
+}
+
+bool server::Client::ready() const
+{
+	if (input.size() - consumed < 4)
+		return false;
+
+	//	a corrupted length is ready too, for receive() to throw on
+	const auto length = utils::bytes::load32(input.data() + consumed);
+	return length < 5 || input.size() - consumed - 4 >= length;
+}
+
+server::Response server::Client::evaluate(std::string_view expression)
+{
+	send(0, expression);
+	flush();
+	return receive();
+}
+
+server::LoadReport server::generateLoad(const std::string& path, const std::vector<std::string>& expressions,
+										unsigned connections, std::size_t requestsPerConnection, std::size_t depth)
+{
+	using Clock = std::chrono::steady_clock;
+
+	if (expressions.empty())
+		throw std::runtime_error("No expressions to send");
+
+	connections = std::max(connections, 1u);
+	depth = std::max<std::size_t>(depth, 1);
+
+	std::vector<std::vector<double>> latencies(connections);
+	std::vector<std::size_t> errors(connections);
+	std::vector<std::thread> threads;
+
+	//	one connection, sending and reading until every response is in
+	const auto drive = [&] (unsigned index) {
+		Client client(path);
+		std::vector<Clock::time_point> sentAt(requestsPerConnection);
+		auto& measured = latencies[index];
+		measured.reserve(requestsPerConnection);
+
+		for (auto sent = std::size_t(0), received = std::size_t(0); received < requestsPerConnection; )
+		{
+			const auto batchStart = sent;
+			while (sent < requestsPerConnection && sent - received < depth) {
+				client.send(static_cast<std::uint32_t>(sent), expressions[(index + sent) % expressions.size()]);
+				++sent;
+			}
+
+			const auto now = Clock::now();
+			std::fill(std::begin(sentAt) + batchStart, std::begin(sentAt) + sent, now);
+			client.flush();
+
+			do {
+				const auto response = client.receive();
+				if (response.id >= sent)
+					throw std::runtime_error("Response to a request never sent (id " + std::to_string(response.id) + ")");
+
+				measured.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt[response.id]).count());
+				errors[index] += response.error;
+				++received;
+			} while (client.ready());
+		}
+	};
+
+	//	a connection that fails stops there, and the first failure is reported rather than ending the process
+	auto failed = 0u;
+	std::string failure;
+	std::mutex failureMutex;
+
+	const auto start = Clock::now();
+
+	for (auto index = 0u; index < connections; ++index)
+		threads.emplace_back([&, index] {
+			try {
+				drive(index);
+			}
+			catch (const std::exception& e) {
+				std::lock_guard<std::mutex> lock(failureMutex);
+				if (failed++ == 0)
+					failure = e.what();
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<double> all;
+	for (const auto& measured : latencies)
+		all.insert(std::end(all), std::begin(measured), std::end(measured));
+	std::sort(std::begin(all), std::end(all));
+
+	const auto percentile = [&all] (double fraction) {
+		return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<std::size_t>(fraction * all.size()))];
+	};
+
+	LoadReport report;
+	report.requests = all.size();
+	report.errors = 0;
+	for (const auto count : errors)
+		report.errors += count;
+	report.seconds = seconds;
+	report.throughput = seconds > 0 ? all.size() / seconds : 0.0;
+	report.p50 = percentile(0.5);
+	report.p99 = percentile(0.99);
+	report.p999 = percentile(0.999);
+	report.failedConnections = failed;
+	report.failure = failure;
+
+	return report;
+}
@@ -0,0 +1,114 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "Budget.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//	Local evaluation service over a Unix domain socket (epoll, so Linux only).
+//
+//	Every frame is a little-endian 32-bit length followed by that many bytes:
+//
+//		request		id (32-bit), expression text as accepted by evaluate()
+//		response	id (32-bit), status (8-bit, 0 for a result and 1 for an error), result or error text
+//
+//	clients may pipeline any number of requests; responses on a connection come back in request order
+
+namespace server
+{
+	struct Options
+	{
+		Options();
+
+		unsigned threads;
+		std::size_t cacheSize;		//	compiled statements kept by each worker
+		std::size_t maxFrame;		//	larger requests close the connection
+		std::size_t maxOutput;		//	bytes of responses pending on a connection past which its requests aren't read
+		compiled::Limits limits;	//	on every request, which exceeding them fails with an error response
+	};
+
+	class Server
+	{
+		public:
+			//	binds and listens on 'path', replacing a stale socket file
+			explicit Server(const std::string& path, const Options& options = {});
+			~Server();
+
+			Server(const Server&) = delete;
+			Server& operator=(const Server&) = delete;
+
+			//	serves on the calling thread plus options.threads - 1 others until stop() is called
+			void run();
+
+			//	safe to call from any thread
+			void stop();
+
+		private:
+			int createPoller();
+			void work(int poller);
+
+			std::string path;
+			Options options;
+			int listener;
+			int wakeup;
+			std::atomic<bool> stopping;
+	};
+
+	struct Response
+	{
+		std::uint32_t id;
+		bool error;
+		std::string text;
+	};
+
+	//	blocking connection to a server
+	class Client
+	{
+		public:
+			explicit Client(const std::string& path);
+			~Client();
+
+			Client(const Client&) = delete;
+			Client& operator=(const Client&) = delete;
+
+			//	queues a request, which is only sent by flush()
+			void send(std::uint32_t id, std::string_view expression);
+			void flush();
+
+			//	waits for the next response, and throws on a frame too short to be one
+			Response receive();
+
+			//	true when a complete response (or a corrupted one) is already buffered, so receive() won't block
+			bool ready() const;
+
+			//	sends a single request and waits for its response, with no other request in flight
+			Response evaluate(std::string_view expression);
+
+		private:
+			int descriptor;
+			std::string output, input;
+			std::size_t consumed;
+	};
+
+	struct LoadReport
+	{
+		std::size_t requests;
+		std::size_t errors;
+		double seconds;
+		double throughput;			//	requests per second
+		double p50, p99, p999;		//	latencies in microseconds
+		unsigned failedConnections;	//	that could not connect or broke off, whose responses so far are counted
+		std::string failure;		//	the message of the first of them
+	};
+
+	//	drives a server from 'connections' threads, each keeping up to 'depth' pipelined requests in flight
+	LoadReport generateLoad(const std::string& path, const std::vector<std::string>& expressions,
+							unsigned connections, std::size_t requestsPerConnection, std::size_t depth);
+}
+
+#endif
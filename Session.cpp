@@ -0,0 +1,415 @@
+#include "Session.h"
+
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Integer.h"
+#include "Utils.h"
+#include "Variable.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <typeinfo>
+
+namespace
+{
+	//	how far past the end of a token (whitespace included) the lexers may look, e.g. "And" checking for "AndAlso"
+	constexpr std::size_t Lookahead = 16;
+
+	bool isParenthesis(const compiled::Instruction& instruction, token::Operator::Type type)
+	{
+		return instruction.code == compiled::Instruction::Code::Operation && instruction.operation.type == type;
+	}
+
+	//	the lexer state after the token, as left in Context::lastToken
+	bool leavesOperator(const compiled::Instruction& instruction)
+	{
+		return instruction.code == compiled::Instruction::Code::Operation && instruction.operation.type != token::Operator::RightParanthesis;
+	}
+
+	bool isSameValue(const token::operand::Ptr& lhs, const token::operand::Ptr& rhs)
+	{
+		return typeid(*lhs) == typeid(*rhs) && lhs->getValue() == rhs->getValue();
+	}
+}
+
+incremental::Session::Session(std::string text)
+	:
+	text(std::move(text)),
+	semicolon(std::string::npos),
+	lexed(true),
+	functions(false),
+	dirty(true)
+{
+	build();
+}
+
+token::operand::Ptr incremental::Session::edit(std::size_t offset, std::size_t removed, std::string_view inserted)
+{
+	if (offset > text.size() || removed > text.size() - offset)
+		throw std::runtime_error("Edit outside the text");
+
+	const auto addsSemicolon = inserted.find(';') != std::string_view::npos;
+	const auto movesSemicolon = semicolon == std::string::npos ? addsSemicolon
+															   : offset <= semicolon && (offset + removed > semicolon || addsSemicolon);
+
+	text.replace(offset, removed, inserted);
+
+	if (movesSemicolon)
+		build();
+	else if (semicolon != std::string::npos && offset <= semicolon) {
+		//	only the preamble changed, so the statement keeps its tokens at shifted positions
+		semicolon = semicolon - removed + inserted.size();
+
+		for (auto& token : tokens) {
+			token.start = token.start - removed + inserted.size();
+			token.end = token.end - removed + inserted.size();
+		}
+
+		parsePreamble();
+	}
+	else {
+		relex(offset, removed, inserted.size());
+
+		//	without a ';' the preamble is parsed from the start of the statement, which may have changed
+		if (semicolon == std::string::npos)
+			parsePreamble();
+	}
+
+	return evaluate();
+}
+
+token::operand::Ptr incremental::Session::evaluate()
+{
+	if (dirty) {
+		result = nullptr;
+		failure = nullptr;
+
+		try {
+			result = compute();
+		}
+		catch (...) {
+			failure = std::current_exception();
+		}
+
+		dirty = false;
+	}
+
+	if (failure)
+		std::rethrow_exception(failure);
+
+	return result;
+}
+
+const std::string& incremental::Session::getText() const
+{
+	return text;
+}
+
+void incremental::Session::build()
+{
+	semicolon = text.find(';');
+	tokens.clear();
+	aliases.clear();
+	bindings.clear();
+	preamble.clear();
+	functions = false;
+
+	for (const auto& var : compiled::parseVariables(text)) {
+		preamble.emplace_back(var.alias, var.operand);
+		functions = functions || !var.body.empty();
+	}
+
+	const auto statementStart = semicolon == std::string::npos ? 0 : semicolon + 1;
+	auto position = text.size() - utils::str::skipWhitespace(std::string_view(text).substr(statementStart)).size();
+	auto afterOperator = true;
+
+	for (Token token; position < text.size(); position = token.end, afterOperator = leavesOperator(token.instruction))
+	{
+		if (!lex(position, afterOperator, token))
+			break;
+		tokens.push_back(token);
+	}
+
+	lexed = position == text.size();
+	dirty = true;
+}
+
+void incremental::Session::relex(std::size_t offset, std::size_t removed, std::size_t inserted)
+{
+	const auto editEnd = offset + removed;
+	const auto shifted = [removed, inserted] (std::size_t position) { return position - removed + inserted; };
+
+	const auto first = static_cast<std::size_t>(std::distance(std::begin(tokens),
+		std::partition_point(std::begin(tokens), std::end(tokens), [offset] (const Token& token) { return token.end + Lookahead <= offset; })));
+
+	invalidateEnclosing(first);
+
+	std::vector<Token> relexed;
+	auto position = std::size_t(0);
+	auto afterOperator = true;
+
+	if (first < tokens.size()) {
+		position = tokens[first].start;
+		afterOperator = tokens[first].afterOperator;
+	}
+	else if (first > 0) {
+		position = tokens.back().end;
+		afterOperator = leavesOperator(tokens.back().instruction);
+	}
+
+	if (first == 0) {
+		const auto statementStart = semicolon == std::string::npos ? 0 : semicolon + 1;
+		position = text.size() - utils::str::skipWhitespace(std::string_view(text).substr(statementStart)).size();
+		afterOperator = true;
+	}
+
+	auto last = first;
+	auto synchronized = false;
+
+	for (Token token; ; position = token.end, afterOperator = leavesOperator(token.instruction))
+	{
+		//	an old token after the edit, at the same position and in the same state, lexes the same again and so does the rest
+		while (last < tokens.size() && (tokens[last].start < editEnd || shifted(tokens[last].start) < position))
+			++last;
+
+		if (last < tokens.size() && shifted(tokens[last].start) == position && tokens[last].afterOperator == afterOperator) {
+			synchronized = true;
+			break;
+		}
+
+		if (position == text.size() || !lex(position, afterOperator, token))
+			break;
+
+		relexed.push_back(token);
+	}
+
+	if (!synchronized) {
+		lexed = position == text.size();
+		last = tokens.size();
+	}
+
+	const auto relexedCount = relexed.size();
+
+	tokens.erase(std::begin(tokens) + first, std::begin(tokens) + last);
+	tokens.insert(std::begin(tokens) + first, std::make_move_iterator(std::begin(relexed)), std::make_move_iterator(std::end(relexed)));
+
+	for (auto index = first + relexedCount; index < tokens.size(); ++index) {
+		tokens[index].start = shifted(tokens[index].start);
+		tokens[index].end = shifted(tokens[index].end);
+	}
+
+	dirty = true;
+}
+
+//	reads one token of the statement at 'position' with the parsers and in the order Expression::compile uses
+bool incremental::Session::lex(std::size_t position, bool afterOperator, Token& token)
+{
+	const auto expression = std::string_view(text).substr(position);
+	std::optional<std::string_view> parsed;
+
+	Context context;
+	context.lastToken = afterOperator ? Context::TokenType::Operator : Context::TokenType::Operand;
+
+	if (token::Operator currentOperator; (parsed = currentOperator.parse(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Operation, nullptr, 0, currentOperator};
+	else if (token::operand::Boolean currentBool; (parsed = currentBool.parse(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Constant, std::make_shared<token::operand::Boolean>(currentBool), 0, {}};
+	else if (token::operand::Currency currentCurrency; (parsed = currentCurrency.parse(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Constant, std::make_shared<token::operand::Currency>(currentCurrency), 0, {}};
+	else if (token::operand::Float currentFloat; (parsed = currentFloat.parse(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Constant, std::make_shared<token::operand::Float>(currentFloat), 0, {}};
+	else if (token::operand::Integer currentInt; (parsed = currentInt.parse(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Constant, std::make_shared<token::operand::Integer>(currentInt), 0, {}};
+	else if (token::Variable currentVariable; (parsed = currentVariable.parseAlias(expression, context)))
+		token.instruction = {compiled::Instruction::Code::Variable, nullptr, addSlot(currentVariable.alias), {}};
+	else
+		return false;
+
+	token.start = position;
+	token.end = text.size() - parsed->size();
+	token.afterOperator = afterOperator;
+	token.group = {};
+
+	return true;
+}
+
+//	drops the operands of every group that contains a token from 'first' on, walking back over the groups that close before it
+void incremental::Session::invalidateEnclosing(std::size_t first)
+{
+	for (auto index = first; index-- > 0;)
+	{
+		auto& token = tokens[index];
+
+		if (isParenthesis(token.instruction, token::Operator::RightParanthesis)) {
+			const auto match = token.group.match;
+
+			if (match && match <= index && tokens[index - match].group.valid && tokens[index - match].group.match == match)
+				index -= match;
+		}
+		else if (isParenthesis(token.instruction, token::Operator::LeftParanthesis)) {
+			if (const auto close = index + token.group.match; token.group.match && close < tokens.size()
+				&& isParenthesis(tokens[close].instruction, token::Operator::RightParanthesis))
+				tokens[close].group.match = 0;
+
+			token.group = {};
+		}
+	}
+}
+
+void incremental::Session::parsePreamble()
+{
+	std::vector<std::pair<std::string, token::operand::Ptr>> parsed;
+	auto defined = false;
+
+	for (const auto& var : compiled::parseVariables(text)) {
+		parsed.emplace_back(var.alias, var.operand);
+		defined = defined || !var.body.empty();
+	}
+
+	//	a changed body has no value to compare, so a preamble that defines functions always counts as changed
+	const auto unchanged = !defined && !functions && parsed.size() == preamble.size()
+		&& std::equal(std::begin(parsed), std::end(parsed), std::begin(preamble), [] (const auto& lhs, const auto& rhs) {
+			return lhs.first == rhs.first && isSameValue(lhs.second, rhs.second);
+		});
+
+	if (unchanged)
+		return;
+
+	preamble = std::move(parsed);
+	functions = defined;
+
+	for (auto slot = std::size_t(0); slot < aliases.size(); ++slot)
+		bindings[slot] = lookup(aliases[slot]);
+
+	for (auto& token : tokens)
+		token.group.valid = false;
+
+	dirty = true;
+}
+
+std::size_t incremental::Session::addSlot(std::string_view alias)
+{
+	if (const auto found = std::find(std::begin(aliases), std::end(aliases), alias); found != std::end(aliases))
+		return static_cast<std::size_t>(std::distance(std::begin(aliases), found));
+
+	aliases.emplace_back(alias);
+	bindings.push_back(lookup(alias));
+	return aliases.size() - 1;
+}
+
+token::operand::Ptr incremental::Session::lookup(std::string_view alias) const
+{
+	const auto found = std::find_if(std::begin(preamble), std::end(preamble), [alias] (const auto& var) { return var.first == alias; });
+	return found == std::end(preamble) ? nullptr : found->second;
+}
+
+token::operand::Ptr incremental::Session::compute()
+{
+	//	the cached tokens stop where the text stops lexing, so only a full compile reports the error as evaluate() does
+	//	the same goes for an operation that reaches outside of its group, where the stacks of the groups interleave
+	const auto fromScratch = [this] {
+		const auto statement = compiled::Expression::compile(text);
+		return statement.evaluate(statement.bind(compiled::parseVariables(text)));
+	};
+
+	if (!lexed || functions)
+		return fromScratch();
+
+	auto index = std::size_t(0);
+	const auto statement = evaluateGroup(index, false);
+
+	if (statement.underflow)
+		return fromScratch();
+
+	if (statement.operands.empty())
+		throw std::runtime_error("Empty expression");
+
+	return statement.operands.back();
+}
+
+//	the shunting-yard of Expression::compile over the tokens from 'index', with every operation applied as soon as it
+//	is emitted; a parenthesized group is one step that pushes its operands, evaluated again only if it isn't valid
+incremental::Session::Group incremental::Session::evaluateGroup(std::size_t& index, bool nested)
+{
+	Group group;
+	std::vector<token::Operator> operators;
+
+	const auto emit = [&group, &operators] {
+		const auto operation = operators.back();
+		operators.pop_back();
+
+		if (group.underflow)
+			return;
+
+		if (group.operands.size() < static_cast<std::size_t>(std::max(operation.arity, 1)))
+			group.underflow = true;
+		else
+			compiled::apply(operation, group.operands);
+	};
+
+	for (; index < tokens.size(); ++index)
+	{
+		const auto& instruction = tokens[index].instruction;
+
+		switch (instruction.code)
+		{
+			case compiled::Instruction::Code::Constant:
+				group.operands.push_back(instruction.constant);
+				break;
+
+			case compiled::Instruction::Code::Variable:
+				if (bindings[instruction.slot])
+					group.operands.push_back(bindings[instruction.slot]);
+				break;
+
+			case compiled::Instruction::Code::Operation:
+				if (instruction.operation.type == token::Operator::LeftParanthesis) {
+					const auto open = index;
+
+					if (!tokens[open].group.valid) {
+						++index;
+						auto inner = evaluateGroup(index, true);
+
+						inner.valid = true;
+						inner.match = index - open;
+						tokens[index].group.match = inner.match;
+						tokens[open].group = std::move(inner);
+					}
+					else
+						index += tokens[open].group.match;
+
+					const auto& inner = tokens[open].group;
+
+					if (inner.underflow)
+						group.underflow = true;
+					else
+						group.operands.insert(std::end(group.operands), std::begin(inner.operands), std::end(inner.operands));
+				}
+				else if (instruction.operation.type == token::Operator::RightParanthesis) {
+					if (!nested)
+						throw std::runtime_error("Mismatched parentheses");
+
+					while (!operators.empty())
+						emit();
+
+					return group;
+				}
+				else {
+					while (instruction.operation.arity > 1 && !operators.empty() && instruction.operation.precedence >= operators.back().precedence)
+						emit();
+
+					operators.push_back(instruction.operation);
+				}
+				break;
+		}
+	}
+
+	if (nested)
+		throw std::runtime_error("Mismatched parentheses");
+
+	while (!operators.empty())
+		emit();
+
+	return group;
+}
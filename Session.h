@@ -0,0 +1,82 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "Expression.h"
+#include "Operand.h"
+
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace incremental
+{
+	//	an expression being edited, which keeps its tokens and the operands of every parenthesized group between edits
+	//
+	//	an edit relexes from the last token that could have read an edited character until the new tokens line up again
+	//	with the old ones, then only the groups that enclose the relexed tokens are parsed and evaluated again; any other
+	//	group is a single operand. edits to the preamble reparse the preamble only and, if a value changed, reevaluate
+	//	the groups without relexing them
+	class Session
+	{
+		public:
+			explicit Session(std::string text);
+
+			//	replaces 'removed' characters at 'offset' with 'inserted' and returns the new result
+			//	throws what evaluate() would throw for the new text
+			token::operand::Ptr edit(std::size_t offset, std::size_t removed, std::string_view inserted);
+
+			//	the result of the current text, as compiling and evaluating it from scratch would give
+			token::operand::Ptr evaluate();
+
+			const std::string& getText() const;
+
+		private:
+			//	the operands a parenthesized group leaves on the stack when evaluated on its own
+			struct Group
+			{
+				bool valid = false;
+				bool underflow = false;		//	an operation in the group needed operands from outside of it
+				std::size_t match = 0;		//	distance to the matching parenthesis, 0 when unknown
+				std::vector<token::operand::Ptr> operands;
+			};
+
+			struct Token
+			{
+				std::size_t start, end;		//	'end' includes the whitespace after the token
+				bool afterOperator;			//	the lexer state the token was read in
+				compiled::Instruction instruction;
+				Group group;
+			};
+
+			void build();
+			void relex(std::size_t offset, std::size_t removed, std::size_t inserted);
+			bool lex(std::size_t position, bool afterOperator, Token& token);
+			void invalidateEnclosing(std::size_t first);
+			void parsePreamble();
+
+			std::size_t addSlot(std::string_view alias);
+			token::operand::Ptr lookup(std::string_view alias) const;
+
+			token::operand::Ptr compute();
+			Group evaluateGroup(std::size_t& index, bool nested);
+
+			std::string text;
+			std::size_t semicolon;
+			std::vector<Token> tokens;
+			bool lexed;			//	false when lexing stopped at a character where no token parses
+			bool functions;		//	the preamble defines functions, whose calls only a full compile inlines
+
+			std::vector<std::pair<std::string, token::operand::Ptr>> preamble;
+			std::vector<std::string> aliases;
+			compiled::Bindings bindings;
+
+			bool dirty;
+			token::operand::Ptr result;
+			std::exception_ptr failure;
+	};
+}
+
+#endif
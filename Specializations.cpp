@@ -0,0 +1,31 @@
+#include "Specializations.h"
+
+compiled::Specializations::Specializations(Expression expression)
+	:
+	expression(std::move(expression))
+{ }
+
+std::shared_ptr<const compiled::Expression> compiled::Specializations::get(const std::string& tenant, const std::vector<token::Variable>& fixed)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (const auto found = residuals.find(tenant); found != std::end(residuals))
+			return found->second;
+	}
+
+	auto residual = std::make_shared<const Expression>(expression.specialize(expression.bind(fixed)));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return residuals.emplace(tenant, std::move(residual)).first->second;
+}
+
+void compiled::Specializations::invalidate(const std::string& tenant)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	residuals.erase(tenant);
+}
+
+const compiled::Expression& compiled::Specializations::getExpression() const
+{
+	return expression;
+}
@@ -0,0 +1,37 @@
+#ifndef SPECIALIZATIONS_H
+#define SPECIALIZATIONS_H
+
+#include "Expression.h"
+#include "Variable.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace compiled
+{
+	//	residual expressions of one formula, specialized once per tenant and shared by every evaluation afterwards
+	class Specializations
+	{
+		public:
+			explicit Specializations(Expression expression);
+
+			//	returns the residual of the tenant, specializing against 'fixed' on first use
+			//	safe to call from several threads; the residual stays valid after invalidate()
+			std::shared_ptr<const Expression> get(const std::string& tenant, const std::vector<token::Variable>& fixed);
+
+			//	drops the residual of the tenant, e.g. after its fixed values changed
+			void invalidate(const std::string& tenant);
+
+			const Expression& getExpression() const;
+
+		private:
+			Expression expression;
+			std::mutex mutex;
+			std::unordered_map<std::string, std::shared_ptr<const Expression>> residuals;
+	};
+}
+
+#endif
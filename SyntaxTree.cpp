@@ -0,0 +1,160 @@
+#include "SyntaxTree.h"
+
+#include "Utils.h"
+#include "Boolean.h"
+#include "Currency.h"
+#include "Float.h"
+#include "Integer.h"
+#include "Variable.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace
+{
+	//	an operator waiting for its right (or only) operand, which takes in every operator of a lower precedence,
+	//	or an open parenthesis
+	struct Pending
+	{
+		token::Operator operation;
+		std::uint32_t left;
+	};
+
+	constexpr auto Closing = std::numeric_limits<int>::max();
+	constexpr auto NoSubtree = std::numeric_limits<std::uint32_t>::max();
+
+	//	the constant at the start of the expression, tried in the order Expression::compile tries them
+	std::optional<std::string_view> parseConstant(std::string_view expression, Context& context, token::operand::Ptr& constant)
+	{
+		std::optional<std::string_view> parsed;
+
+		if (token::operand::Boolean currentBool; (parsed = currentBool.parse(expression, context)))
+			constant = std::make_shared<token::operand::Boolean>(currentBool);
+		else if (token::operand::Currency currentCurrency; (parsed = currentCurrency.parse(expression, context)))
+			constant = std::make_shared<token::operand::Currency>(currentCurrency);
+		else if (token::operand::Float currentFloat; (parsed = currentFloat.parse(expression, context)))
+			constant = std::make_shared<token::operand::Float>(currentFloat);
+		else if (token::operand::Integer currentInt; (parsed = currentInt.parse(expression, context)))
+			constant = std::make_shared<token::operand::Integer>(currentInt);
+
+		return parsed;
+	}
+}
+
+compiled::SyntaxTree compiled::SyntaxTree::parse(std::string_view expression)
+{
+	if (const auto expressionStart = expression.find(';'); expressionStart != std::string_view::npos)
+		expression.remove_prefix(expressionStart + 1);
+
+	SyntaxTree tree;
+	std::vector<Pending> pending;
+	Context context;
+
+	//	the subtree just completed while an operator is expected, NoSubtree while an operand is
+	auto current = NoSubtree;
+
+	//	completes the pending operators whose operand ends before an operator of the given precedence, starting from the
+	//	subtree 'operand', and returns the subtree they make
+	const auto reduce = [&tree, &pending] (int precedence, std::uint32_t operand) {
+		while (!pending.empty() && pending.back().operation.type != token::Operator::LeftParanthesis && precedence >= pending.back().operation.precedence)
+		{
+			const auto& top = pending.back();
+			const auto binary = top.operation.arity > 1;
+
+			operand = tree.add({Node::Kind::Operation, 0, top.operation, {binary ? top.left : operand, binary ? operand : 0}});
+			pending.pop_back();
+		}
+
+		return operand;
+	};
+
+	for (expression = utils::str::skipWhitespace(expression); !expression.empty(); )
+	{
+		std::optional<std::string_view> parsed;
+
+		if (token::Operator currentOperator; (parsed = currentOperator.parse(expression, context))) {
+			const auto opens = currentOperator.type == token::Operator::LeftParanthesis
+							   || (currentOperator.arity < 2 && currentOperator.type != token::Operator::RightParanthesis);
+
+			if (opens && current != NoSubtree)
+				throw std::runtime_error("Missing operator");
+			if (!opens && current == NoSubtree)
+				throw std::runtime_error("Missing operand");
+
+			if (currentOperator.type == token::Operator::RightParanthesis) {
+				current = reduce(Closing, current);
+				if (pending.empty())
+					throw std::runtime_error("Mismatched parentheses");
+
+				pending.pop_back();
+			}
+			else if (opens)
+				pending.push_back({currentOperator, 0});
+			else {
+				pending.push_back({currentOperator, reduce(currentOperator.precedence, current)});
+				current = NoSubtree;
+			}
+		}
+		else {
+			token::operand::Ptr constant;
+			token::Variable currentVariable;
+
+			if (!(parsed = parseConstant(expression, context, constant)) && !(parsed = currentVariable.parseAlias(expression, context)))
+				throw std::runtime_error("Unexpected '" + std::string(1, expression.front()) + "'");
+
+			if (current != NoSubtree)
+				throw std::runtime_error("Missing operator");
+
+			if (constant) {
+				tree.constants.push_back(std::move(constant));
+				current = tree.add({Node::Kind::Constant, static_cast<std::uint32_t>(tree.constants.size() - 1), {}, {0, 0}});
+			}
+			else
+				current = tree.add({Node::Kind::Variable, tree.addSlot(currentVariable.alias), {}, {0, 0}});
+		}
+
+		expression = parsed.value();
+	}
+
+	if (current == NoSubtree)
+		throw std::runtime_error(tree.nodes.empty() && pending.empty() ? "Empty expression" : "Missing operand");
+
+	reduce(Closing, current);
+	if (!pending.empty())
+		throw std::runtime_error("Mismatched parentheses");
+
+	return tree;
+}
+
+const std::vector<compiled::SyntaxTree::Node>& compiled::SyntaxTree::getNodes() const
+{
+	return nodes;
+}
+
+const std::vector<token::operand::Ptr>& compiled::SyntaxTree::getConstants() const
+{
+	return constants;
+}
+
+const std::vector<std::string>& compiled::SyntaxTree::getAliases() const
+{
+	return aliases;
+}
+
+std::uint32_t compiled::SyntaxTree::add(Node node)
+{
+	nodes.push_back(node);
+	return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+std::uint32_t compiled::SyntaxTree::addSlot(std::string_view alias)
+{
+	const auto found = std::find(std::begin(aliases), std::end(aliases), alias);
+	if (found != std::end(aliases))
+		return static_cast<std::uint32_t>(std::distance(std::begin(aliases), found));
+
+	aliases.emplace_back(alias);
+	return static_cast<std::uint32_t>(aliases.size() - 1);
+}
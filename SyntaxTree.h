@@ -0,0 +1,51 @@
+#ifndef SYNTAX_TREE_H
+#define SYNTAX_TREE_H
+
+#include "Operand.h"
+#include "Operator.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace compiled
+{
+	//	a statement parsed into a tree kept in one array, where every node follows the nodes of its operands, so the
+	//	array read in order is the postfix program Expression::compile would emit and the root is the last node
+	//
+	//	the parser is precedence climbing over the same tokens as Expression::compile, with its pending operators on an
+	//	explicit stack rather than the call stack, so nesting is bounded by memory only; unlike Expression::compile it
+	//	rejects a statement that doesn't form a single tree (two operands in a row, an operator without its operands),
+	//	and it doesn't inline calls to the functions of a preamble
+	class SyntaxTree
+	{
+		public:
+			struct Node
+			{
+				enum class Kind : std::uint8_t { Constant, Variable, Operation };
+
+				Kind kind;
+				std::uint32_t value;				//	Constant: index of the constant, Variable: slot
+				token::Operator operation;
+				std::uint32_t operands[2];			//	Operation: the left (or only) operand, then the right one
+			};
+
+			//	parses the statement after the ';' of the expression (or the whole expression if there is none)
+			static SyntaxTree parse(std::string_view expression);
+
+			const std::vector<Node>& getNodes() const;
+			const std::vector<token::operand::Ptr>& getConstants() const;
+			const std::vector<std::string>& getAliases() const;
+
+		private:
+			std::uint32_t add(Node node);
+			std::uint32_t addSlot(std::string_view alias);
+
+			std::vector<Node> nodes;
+			std::vector<token::operand::Ptr> constants;
+			std::vector<std::string> aliases;
+	};
+}
+
+#endif
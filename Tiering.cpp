@@ -0,0 +1,114 @@
+#include "Tiering.h"
+
+#include <exception>
+#include <system_error>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+}
+
+compiled::TieredExpression::TieredExpression(std::string_view expression, std::size_t threshold)
+	:
+	threshold(threshold),
+	baselineTime(0),
+	current(nullptr),
+	evaluations{0, 0},
+	promoting(false),
+	optimizedTime(0)
+{
+	const auto start = Clock::now();
+	baseline = Expression::compileBaseline(expression);
+	baselineTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+	current = &baseline;
+
+	if (threshold == 0)
+	{
+		promoting = true;
+		promote();
+	}
+}
+
+compiled::TieredExpression::~TieredExpression()
+{
+	waitForPromotion();
+}
+
+//	only the evaluation that reaches the threshold starts the optimizer, so the count is all the baseline tier pays
+token::operand::Ptr compiled::TieredExpression::evaluate(const Bindings& bindings) const
+{
+	const auto expression = current.load(std::memory_order_acquire);
+
+	if (expression == &baseline)
+	{
+		if (evaluations[0].fetch_add(1, std::memory_order_relaxed) + 1 == threshold && !promoting.exchange(true))
+			startOptimizer();
+	}
+	else
+		evaluations[1].fetch_add(1, std::memory_order_relaxed);
+
+	return expression->evaluate(bindings);
+}
+
+compiled::Bindings compiled::TieredExpression::bind(const std::vector<token::Variable>& vars) const
+{
+	return baseline.bind(vars);
+}
+
+compiled::Tier compiled::TieredExpression::getTier() const
+{
+	return current.load(std::memory_order_acquire) == &baseline ? Tier::Baseline : Tier::Optimized;
+}
+
+const compiled::Expression& compiled::TieredExpression::getExpression() const
+{
+	return *current.load(std::memory_order_acquire);
+}
+
+compiled::TierStatistics compiled::TieredExpression::statistics(Tier tier) const
+{
+	const auto evaluated = evaluations[static_cast<std::size_t>(tier)].load(std::memory_order_relaxed);
+
+	if (tier == Tier::Baseline)
+		return {evaluated, baseline.getInstructions().size(), baselineTime};
+
+	if (getTier() == Tier::Baseline)
+		return {evaluated, 0, std::chrono::nanoseconds(0)};
+
+	return {evaluated, optimized->getInstructions().size(), optimizedTime};
+}
+
+void compiled::TieredExpression::waitForPromotion()
+{
+	std::lock_guard<std::mutex> lock(optimizerMutex);
+
+	if (optimizer.joinable())
+		optimizer.join();
+}
+
+//	an optimizer that can't be started leaves the expression in the baseline tier rather than failing the evaluation
+void compiled::TieredExpression::startOptimizer() const
+{
+	std::lock_guard<std::mutex> lock(optimizerMutex);
+
+	try {
+		optimizer = std::thread([this] { promote(); });
+	}
+	catch (const std::system_error&) {
+	}
+}
+
+void compiled::TieredExpression::promote() const
+{
+	try {
+		const auto start = Clock::now();
+		optimized = std::make_unique<const Expression>(baseline.optimize());
+		optimizedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+		current.store(optimized.get(), std::memory_order_release);
+	}
+	catch (const std::exception&) {
+		optimized.reset();
+	}
+}
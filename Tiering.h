@@ -0,0 +1,83 @@
+#ifndef TIERING_H
+#define TIERING_H
+
+#include "Expression.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace compiled
+{
+	enum class Tier { Baseline, Optimized };
+
+	struct TierStatistics
+	{
+		std::size_t evaluations;
+		std::size_t instructions;				//	0 for a tier not reached yet
+		std::chrono::nanoseconds compileTime;	//	of the tier itself, from the text for the baseline and from the baseline for the optimized tier
+	};
+
+	//	an expression compiled at first without optimizations, which Expression::optimize re-optimizes on a thread of its
+	//	own once it has been evaluated 'threshold' times, and which every evaluation after the swap runs optimized
+	//
+	//	the optimized tier folds, strength reduces and fuses; it doesn't specialize on operand types, which are only
+	//	known per operation at run time
+	//
+	//	both tiers give the same results and keep the same slots, so bindings made for one hold for the other; an
+	//	expression whose optimization fails (e.g. a constant subtree that throws) stays in the baseline tier
+	class TieredExpression
+	{
+		public:
+			static constexpr std::size_t DefaultThreshold = 1000;
+
+			//	a threshold of 0 optimizes at once, on the calling thread
+			explicit TieredExpression(std::string_view expression, std::size_t threshold = DefaultThreshold);
+
+			//	waits for an optimization still running
+			~TieredExpression();
+
+			TieredExpression(const TieredExpression&) = delete;
+			TieredExpression& operator=(const TieredExpression&) = delete;
+
+			//	safe to call from several threads
+			token::operand::Ptr evaluate(const Bindings& bindings) const;
+
+			Bindings bind(const std::vector<token::Variable>& vars) const;
+
+			//	the tier the next evaluation runs in
+			Tier getTier() const;
+			const Expression& getExpression() const;
+
+			TierStatistics statistics(Tier tier) const;
+
+			//	waits for the optimization started by the evaluations so far, if any, to be swapped in (or to fail);
+			//	safe to call from several threads, and while others evaluate
+			void waitForPromotion();
+
+		private:
+			void startOptimizer() const;
+			void promote() const;
+
+			Expression baseline;
+			std::size_t threshold;
+			std::chrono::nanoseconds baselineTime;
+
+			mutable std::atomic<const Expression*> current;
+			mutable std::atomic<std::size_t> evaluations[2];
+			mutable std::atomic<bool> promoting;
+			mutable std::thread optimizer;
+			mutable std::mutex optimizerMutex;		//	the optimizer is started and joined under it
+
+			//	written by the optimizer before it swaps the optimized expression in
+			mutable std::unique_ptr<const Expression> optimized;
+			mutable std::chrono::nanoseconds optimizedTime;
+	};
+}
+
+#endif
@@ -1,6 +1,128 @@
 #include "Utils.h"
 
-#include <locale>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UTILS_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILS_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	constexpr std::array<std::uint8_t, 256> makeCharClasses()
+	{
+		std::array<std::uint8_t, 256> classes {};
+
+		for (const auto ch : {' ', '\t', '\n', '\v', '\f', '\r'})
+			classes[static_cast<unsigned char>(ch)] |= utils::str::Space;
+
+		for (auto ch = '0'; ch <= '9'; ++ch)
+			classes[static_cast<unsigned char>(ch)] |= utils::str::Digit | utils::str::Identifier;
+
+		for (auto ch = 'a'; ch <= 'z'; ++ch) {
+			classes[static_cast<unsigned char>(ch)] |= utils::str::Alpha | utils::str::Identifier;
+			classes[static_cast<unsigned char>(ch - 'a' + 'A')] |= utils::str::Alpha;
+		}
+
+		classes[static_cast<unsigned char>('_')] |= utils::str::Identifier;
+		return classes;
+	}
+
+	unsigned firstSet(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+	}
+
+#ifdef UTILS_SSE2
+	//	bytes in [low, low + count) as 0xFF, compared unsigned through the wrap-around of the subtraction
+	__m128i inRange(__m128i chars, char low, char count)
+	{
+		const auto shifted = _mm_sub_epi8(chars, _mm_set1_epi8(low));
+		return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(count - 1)), shifted);
+	}
+
+	__m128i matches(__m128i chars, utils::str::CharClass charClass)
+	{
+		switch (charClass)
+		{
+			case utils::str::Space:
+				return _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), inRange(chars, '\t', 5));
+			case utils::str::Digit:
+				return inRange(chars, '0', 10);
+			default:
+				return _mm_or_si128(_mm_or_si128(inRange(chars, 'a', 26), inRange(chars, '0', 10)), _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')));
+		}
+	}
+#endif
+
+#ifdef UTILS_AVX2
+	__m256i inRange(__m256i chars, char low, char count)
+	{
+		const auto shifted = _mm256_sub_epi8(chars, _mm256_set1_epi8(low));
+		return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(count - 1)), shifted);
+	}
+
+	__m256i matches(__m256i chars, utils::str::CharClass charClass)
+	{
+		switch (charClass)
+		{
+			case utils::str::Space:
+				return _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')), inRange(chars, '\t', 5));
+			case utils::str::Digit:
+				return inRange(chars, '0', 10);
+			default:
+				return _mm256_or_si256(_mm256_or_si256(inRange(chars, 'a', 26), inRange(chars, '0', 10)), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_')));
+		}
+	}
+#endif
+
+	std::size_t countClass(std::string_view str, utils::str::CharClass charClass)
+	{
+		const auto data = str.data();
+		auto position = std::size_t(0);
+
+		//	runs are usually short, so the first characters are checked one by one before going wide
+		for (const auto end = std::min<std::size_t>(str.size(), 4); position < end; ++position)
+			if (!utils::str::isClass(data[position], charClass))
+				return position;
+
+#ifdef UTILS_AVX2
+		for (; position + 32 <= str.size(); position += 32) {
+			const auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+			if (const auto mask = ~static_cast<unsigned>(_mm256_movemask_epi8(matches(chars, charClass))))
+				return position + firstSet(mask);
+		}
+#endif
+
+#ifdef UTILS_SSE2
+		for (; position + 16 <= str.size(); position += 16) {
+			const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+			if (const auto mask = ~static_cast<unsigned>(_mm_movemask_epi8(matches(chars, charClass))) & 0xFFFFu)
+				return position + firstSet(mask);
+		}
+#endif
+
+		while (position < str.size() && utils::str::isClass(data[position], charClass))
+			++position;
+
+		return position;
+	}
+}
+
+const std::array<std::uint8_t, 256> utils::str::charClasses = makeCharClasses();
 
 bool utils::str::isPrefix(std::string_view lhs, std::string_view rhs)
 {
@@ -14,6 +136,43 @@ bool utils::str::inString(std::string_view str, char character)
 
 std::string_view utils::str::skipWhitespace(std::string_view str)
 {
-	const auto found = std::find_if(str.begin(), str.end(), [] (char ch) { return !std::isspace<char>(ch, std::locale::classic()); });
-	return str.substr(std::distance(str.begin(), found));
-}
\ No newline at end of file
+	return str.substr(countWhitespace(str));
+}
+
+std::size_t utils::str::countWhitespace(std::string_view str)
+{
+	return countClass(str, Space);
+}
+
+std::size_t utils::str::countDigits(std::string_view str)
+{
+	return countClass(str, Digit);
+}
+
+std::size_t utils::str::countIdentifier(std::string_view str)
+{
+	return countClass(str, Identifier);
+}
+
+std::uint32_t utils::bytes::load32(const char* at)
+{
+	const auto bytes = reinterpret_cast<const unsigned char*>(at);
+	return std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 | std::uint32_t(bytes[2]) << 16 | std::uint32_t(bytes[3]) << 24;
+}
+
+std::uint64_t utils::bytes::load64(const char* at)
+{
+	return std::uint64_t(load32(at)) | std::uint64_t(load32(at + 4)) << 32;
+}
+
+void utils::bytes::store32(std::string& buffer, std::uint32_t value)
+{
+	for (auto shift = 0; shift < 32; shift += 8)
+		buffer.push_back(static_cast<char>(value >> shift & 0xFF));
+}
+
+void utils::bytes::store64(std::string& buffer, std::uint64_t value)
+{
+	store32(buffer, static_cast<std::uint32_t>(value));
+	store32(buffer, static_cast<std::uint32_t>(value >> 32));
+}
@@ -2,6 +2,10 @@
 #define UTILS_H
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <string_view>
 #include <optional>
 
@@ -46,6 +50,37 @@ namespace utils
 		//	returns the string_view without any whitespaces at the start of the string
 		std::string_view skipWhitespace(std::string_view str);
 
+		//	locale-free character classes, matching the "C" locale for ASCII and empty for every other byte
+		enum CharClass : std::uint8_t
+		{
+			Space = 1,			//	' ', '\t', '\n', '\v', '\f', '\r'
+			Digit = 2,			//	'0' - '9'
+			Alpha = 4,			//	'a' - 'z', 'A' - 'Z'
+			Identifier = 8		//	'a' - 'z', '0' - '9', '_' (the characters after the first one of a variable alias)
+		};
+
+		extern const std::array<std::uint8_t, 256> charClasses;
+
+		inline bool isClass(char ch, std::uint8_t charClass)
+		{
+			return (charClasses[static_cast<unsigned char>(ch)] & charClass) != 0;
+		}
+
+		//	length of the run of characters of a class at the start of the string, scanned 16 or 32 bytes at a time when SSE2 or AVX2 is available
+		std::size_t countWhitespace(std::string_view str);
+		std::size_t countDigits(std::string_view str);
+		std::size_t countIdentifier(std::string_view str);
+
+	}
+
+	namespace bytes
+	{
+		//	little-endian integers read from and appended to byte buffers, independent of alignment and host order
+		std::uint32_t load32(const char* at);
+		std::uint64_t load64(const char* at);
+
+		void store32(std::string& buffer, std::uint32_t value);
+		void store64(std::string& buffer, std::uint64_t value);
 	}
 
 }
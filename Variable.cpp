@@ -2,11 +2,10 @@
 
 #include "Utils.h"
 #include "Boolean.h"
+#include "Currency.h"
 #include "Integer.h"
 #include "Float.h"
 
-#include <cctype>
-
 using namespace std::string_view_literals;
 
 std::optional<std::string_view> token::Variable::parse(std::string_view expression)
@@ -14,6 +13,13 @@ std::optional<std::string_view> token::Variable::parse(std::string_view expressi
 	auto parsed = parseAlias(expression);
 	if (!parsed) return {};
 
+	operand = nullptr;
+	parameters.clear();
+	body = {};
+
+	if (!parsed->empty() && parsed->front() == '(')
+		return parseDefinition(parsed->substr(1));
+
 	parsed = parseAsignment(parsed.value());
 	if (!parsed) return {};
 
@@ -22,19 +28,19 @@ std::optional<std::string_view> token::Variable::parse(std::string_view expressi
 
 std::optional<std::string_view> token::Variable::parseAlias(std::string_view expression, Context& context)
 {
-	if (expression.empty() || !std::isalpha(expression.front()))
+	if (expression.empty() || !utils::str::isClass(expression.front(), utils::str::Alpha))
 		return {};
 
 	context.lastToken = Context::TokenType::Variable;
 
-	static const auto delimiters = "abcdefghijklmnopqrstuvwxyz0123456789_";
-	alias = expression.substr(0, expression.find_first_not_of(delimiters, 1));
+	alias = expression.substr(0, 1 + utils::str::countIdentifier(expression.substr(1)));
 	return utils::str::skipWhitespace(expression.substr(alias.length()));
 }
 
 std::optional<std::string_view> token::Variable::parseAlias(std::string_view expression)
 {
-	return parseAlias(expression, std::move(Context()));
+	Context context;
+	return parseAlias(expression, context);
 }
 
 std::optional<std::string_view> token::Variable::parseAsignment(std::string_view expression)
@@ -49,31 +55,88 @@ std::optional<std::string_view> token::Variable::parseValue(std::string_view exp
 {
 	if (expression.empty()) return {};
 
-	auto isPositive = 0u;
+	auto isPositive = std::size_t(0);
 	if (isPositive = "-+"sv.find(expression.front()); isPositive != std::string_view::npos)
 		expression = utils::str::skipWhitespace(expression.substr(1));
 
+	Context context;
 	std::optional<std::string_view> parsed;
-	if (token::operand::Boolean currentBool; parsed = currentBool.parse(expression, std::move(Context())))
+	if (token::operand::Boolean currentBool; (parsed = currentBool.parse(expression, context)))
 		operand = std::make_unique<token::operand::Boolean>(currentBool);
-	else if (token::operand::Float currentFloat; parsed = currentFloat.parse(expression, std::move(Context())))
+	else if (token::operand::Currency currentCurrency; (parsed = currentCurrency.parse(expression, context)))
+		operand = std::make_unique<token::operand::Currency>(currentCurrency);
+	else if (token::operand::Float currentFloat; (parsed = currentFloat.parse(expression, context)))
 		operand = std::make_unique<token::operand::Float>(currentFloat);
-	else if (token::operand::Integer currentInt; parsed = currentInt.parse(expression, std::move(Context())))
+	else if (token::operand::Integer currentInt; (parsed = currentInt.parse(expression, context)))
 		operand = std::make_unique<token::operand::Integer>(currentInt);
 	else
 		return  {};
 
 	if (!isPositive) {
-		operand = std::visit([] (auto&& val) -> token::operand::Ptr {
-			using T = std::decay_t<decltype(val)>;
+		if (const auto currency = dynamic_cast<const token::operand::Currency*>(operand.get()))
+			operand = std::make_unique<token::operand::Currency>(-currency->getScaled());
+		else
+			operand = std::visit([] (auto&& val) -> token::operand::Ptr {
+				using T = std::decay_t<decltype(val)>;
+
+				if constexpr (std::is_same_v<T, double>)
+					return std::make_unique<token::operand::Float>(-val);
+				else
+					return std::make_unique<token::operand::Integer>(-val);
+
+			}, operand->getValue());
+	}
 
-			if constexpr (std::is_same_v<T, double>)
-				return std::make_unique<token::operand::Float>(-val);
-			else
-				return std::make_unique<token::operand::Integer>(-val);
+	return utils::str::skipWhitespace(parsed.value());
+}
 
-		}, operand->getValue());
+std::optional<std::string_view> token::Variable::parseDefinition(std::string_view expression)
+{
+	expression = utils::str::skipWhitespace(expression);
+
+	while (expression.empty() || expression.front() != ')')
+	{
+		if (!parameters.empty()) {
+			if (expression.empty() || expression.front() != ',')
+				return {};
+			expression = utils::str::skipWhitespace(expression.substr(1));
+		}
+
+		if (expression.empty() || !utils::str::isClass(expression.front(), utils::str::Alpha))
+			return {};
+
+		parameters.push_back(expression.substr(0, 1 + utils::str::countIdentifier(expression.substr(1))));
+		expression = utils::str::skipWhitespace(expression.substr(parameters.back().length()));
 	}
 
-	return utils::str::skipWhitespace(parsed.value());
+	auto parsed = parseAsignment(utils::str::skipWhitespace(expression.substr(1)));
+	if (!parsed) return {};
+
+	auto depth = 0;
+	auto length = std::size_t(0);
+
+	for (; length < parsed->size(); ++length)
+	{
+		const auto ch = (*parsed)[length];
+
+		if (ch == ';' || (ch == ',' && depth == 0))
+			break;
+		if (ch == '(')
+			++depth;
+		else if (ch == ')')
+			--depth;
+	}
+
+	body = parsed->substr(0, length);
+	while (!body.empty() && utils::str::isClass(body.back(), utils::str::Space))
+		body.remove_suffix(1);
+
+	if (body.empty())
+		return {};
+
+	auto rest = parsed->substr(length);
+	if (!rest.empty() && rest.front() == ',')
+		rest.remove_prefix(1);
+
+	return utils::str::skipWhitespace(rest);
 }
\ No newline at end of file
@@ -6,9 +6,12 @@
 
 #include <string_view>
 #include <optional>
+#include <vector>
 
 namespace token
 {
+	//	'alias = value', or a function definition 'alias(parameters) = body' whose body runs up to the next ',' or ';'
+	//	outside of parentheses; a function has a body and no operand
 	struct Variable
 	{
 			std::optional<std::string_view> parse(std::string_view expression);
@@ -17,10 +20,14 @@ namespace token
 			std::string_view alias;
 			operand::Ptr operand;
 
+			std::vector<std::string_view> parameters;
+			std::string_view body;
+
 		private:
 			std::optional<std::string_view> parseAlias(std::string_view expression);
 			std::optional<std::string_view> parseAsignment(std::string_view expression);
 			std::optional<std::string_view> parseValue(std::string_view expression);
+			std::optional<std::string_view> parseDefinition(std::string_view expression);
 	};
 }
 
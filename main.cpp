@@ -1,126 +1,262 @@
+#include <atomic>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
-#include <stack>
+#include <thread>
 #include <vector>
+#include <chrono>
+#include <csignal>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 
-#include "Context.h"
-#include "Variable.h"
+#include "Batch.h"
+#include "CInterface.h"
+#include "Benchmark.h"
+#include "Catalogue.h"
+#include "Cost.h"
+#include "Explain.h"
+#include "Expression.h"
+#include "Filter.h"
 #include "Float.h"
+#include "Gradient.h"
 #include "Integer.h"
-#include "Boolean.h"
-#include "Operator.h"
+#include "Interval.h"
+#include "Registry.h"
+#include "Serialization.h"
+#include "Session.h"
+#include "SyntaxTree.h"
+#include "Tiering.h"
+#include "Server.h"
+#include "Specializations.h"
 #include "Utils.h"
+#include "Variable.h"
 
-void processTopOperation(std::stack<token::Operator>& operators, std::stack<token::operand::Ptr>& operands)
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+std::string evaluate(const std::string& expression) 
 {
-	auto currentOperator = operators.top();
-	operators.pop();
-	auto currentOperand = operands.top();
-	operands.pop();
+	std::shared_ptr<token::operand::Operand> result;
 
-	if (currentOperator.arity <= 1)
-		operands.push(currentOperator.compute(currentOperand));
-	else {
-		auto prevOperand = operands.top();
-		operands.pop();
-		operands.push(currentOperator.compute(prevOperand, currentOperand));
+	try {
+		const std::vector<token::Variable> vars = compiled::parseVariables(expression);
+		const auto statement = compiled::Expression::compile(expression);
+		result = statement.evaluate(statement.bind(vars));
+	}
+	catch (const std::exception& e) {
+		return "Error(s):\n\n" + std::string(e.what()) + "\n";
 	}
+
+	return result->toString();
 }
 
-std::vector<token::Variable> parseVariables(std::string_view expression)
+std::string evaluateTable(std::string_view formula, std::string_view table, const batch::Options& options = {})
 {
-	expression = utils::str::skipWhitespace(expression);
+	std::ostringstream output;
+	batch::evaluate(formula, table, output, options);
+	return output.str();
+}
 
-	std::vector<token::Variable> vars;
+std::string evaluateImage(const std::string& image, std::string_view name, const std::string& preamble)
+{
+	const auto expression = serialized::Catalogue(image).find(name);
+	return expression->evaluate(expression->bind(compiled::parseVariables(preamble)))->toString();
+}
 
-	for (token::Variable variable; auto parsed = variable.parse(expression); expression = parsed.value())
-		vars.push_back(variable);
+bool isRejected(const std::string& image)
+{
+	try { serialized::Catalogue catalogue(image); }
+	catch (const std::runtime_error&) { return true; }
 
-	return vars;
+	return false;
 }
 
-std::shared_ptr<token::operand::Operand> parseStatement(std::string_view expression, const std::vector<token::Variable>& vars)
+//	evaluates the formulas as one shared catalogue, formatting every result as evaluate() would
+std::vector<std::string> evaluateCatalogue(const std::vector<std::string>& formulas, const std::string& preamble)
 {
-	std::stack<token::Operator> operators;
-	std::stack<token::operand::Ptr> operands;
-	Context context;
+	compiled::Catalogue catalogue;
+	for (const auto& formula : formulas)
+		catalogue.add(formula, formula);
 
-	if (const auto expressionStart = expression.find(';'); expressionStart != std::string::npos)
-		expression.remove_prefix(expressionStart + 1);
-	expression = utils::str::skipWhitespace(expression);
+	std::vector<std::string> results;
+	for (const auto& result : catalogue.evaluate(catalogue.bind(compiled::parseVariables(preamble))))
+		results.push_back(result.error.empty() ? result.value->toString() : "Error(s):\n\n" + result.error + "\n");
 
-	for (std::optional<std::string_view> parsed; !expression.empty(); expression = parsed.value())
-	{
-		if (token::Operator currentOperator; parsed = currentOperator.parse(expression, context)) {
-			if (currentOperator.type == token::Operator::Type::RightParanthesis) {
-				while (operators.top().type != token::Operator::Type::LeftParanthesis)
-					processTopOperation(operators, operands);
+	return results;
+}
 
-				operators.pop();
-			}
-			else {
-				while (currentOperator.arity > 1 
-					   && !operators.empty() 
-					   && currentOperator.precedence >= operators.top().precedence 
-					   && operators.top().type != token::Operator::Type::LeftParanthesis)
-				{
-					processTopOperation(operators, operands);
-				}
+//	the exact bits of the Float result of the expression, NaN included
+std::uint64_t floatBits(const std::string& expression)
+{
+	const auto statement = compiled::Expression::compile(expression);
+	const auto value = std::get<double>(statement.evaluate(statement.bind(compiled::parseVariables(expression)))->getValue());
 
-				operators.push(currentOperator);
-			}
+	auto bits = std::uint64_t(0);
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
 
-			continue;
-		}
+//	the rows of the named columns where the formula passes, through a filter or by evaluating every row on its own
+std::vector<std::size_t> filterRows(const std::string& formula, const std::vector<std::pair<std::string, compiled::Column>>& table, std::size_t rows, bool rowByRow = false)
+{
+	const auto statement = compiled::Expression::compile(formula);
+	const auto constants = statement.bind(compiled::parseVariables(formula));
 
-		if (token::operand::Boolean currentBool; parsed = currentBool.parse(expression, context)) {
-			operands.push(std::make_unique<token::operand::Boolean>(currentBool));
-			continue;
-		}
+	std::vector<compiled::Column> columns(statement.getAliases().size());
+	for (const auto& [name, column] : table)
+		if (const auto slot = statement.slotOf(name))
+			columns[*slot] = column;
 
-		if (token::operand::Float currentFloat; parsed = currentFloat.parse(expression, context)) {
-			operands.push(std::make_unique<token::operand::Float>(currentFloat));
-			continue;
-		}
+	if (!rowByRow)
+		return compiled::Filter(statement, constants).select(columns, rows);
 
-		if (token::operand::Integer currentInt; parsed = currentInt.parse(expression, context)) {
-			operands.push(std::make_unique<token::operand::Integer>(currentInt));
-			continue;
-		}
+	std::vector<std::size_t> selection;
 
-		if (token::Variable currentVariable; parsed = currentVariable.parseAlias(expression, context)) {
-			auto found = std::find_if(std::begin(vars), std::end(vars),
-											[&currentVariable] (const token::Variable& var) { return currentVariable.alias == var.alias; });
+	for (auto row = std::size_t(0); row < rows; ++row)
+	{
+		auto bindings = constants;
+		for (auto slot = std::size_t(0); slot < bindings.size(); ++slot)
+			if (!bindings[slot])
+				bindings[slot] = std::visit([row] (const auto& values) -> token::operand::Ptr {
+					if constexpr (std::is_same_v<typename std::decay_t<decltype(values)>::value_type, double>)
+						return std::make_shared<token::operand::Float>(values[row]);
+					else
+						return std::make_shared<token::operand::Integer>(values[row]);
+				}, columns[slot]);
 
-			if (found != std::end(vars))
-				operands.push(found->operand);
+		if (std::visit([] (auto&& val) { return val != 0; }, statement.evaluate(bindings)->getValue()))
+			selection.push_back(row);
+	}
 
-			continue;
-		}
+	return selection;
+}
+
+//	as filterRows, pruning the zones of 'zoneRows' rows the predicate is always true or always false on
+std::vector<std::size_t> filterZones(const std::string& formula, const std::vector<std::pair<std::string, compiled::Column>>& table, std::size_t rows, std::size_t zoneRows)
+{
+	const auto statement = compiled::Expression::compile(formula);
+
+	std::vector<compiled::Column> columns(statement.getAliases().size());
+	for (const auto& [name, column] : table)
+		if (const auto slot = statement.slotOf(name))
+			columns[*slot] = column;
+
+	const compiled::Filter filter(statement, statement.bind(compiled::parseVariables(formula)));
+	return filter.select(columns, rows, compiled::zoneMap(columns, rows, zoneRows));
+}
+
+//	bounds of the statement with every variable in its interval
+compiled::Interval boundOf(const std::string& expression, const std::vector<compiled::Interval>& slots)
+{
+	return compiled::bound(compiled::Expression::compile(expression), slots);
+}
+
+//	applies the edit to the session, formatting the result as evaluate() would
+std::string editSession(incremental::Session& session, std::size_t offset, std::size_t removed, std::string_view inserted)
+{
+	try {
+		return session.edit(offset, removed, inserted)->toString();
+	}
+	catch (const std::exception& e) {
+		return "Error(s):\n\n" + std::string(e.what()) + "\n";
 	}
+}
 
-	while (!operators.empty())
-		processTopOperation(operators, operands);
+//	whether the syntax tree of the statement lowers to the program compiled from its text, instruction for instruction
+bool compilesAlike(const std::string& expression)
+{
+	const auto text = compiled::Expression::compile(expression), tree = compiled::Expression::compile(compiled::SyntaxTree::parse(expression));
+	const auto& expected = text.getInstructions();
+	const auto& lowered = tree.getInstructions();
 
-	return operands.top();
+	return text.getAliases() == tree.getAliases()
+		&& std::equal(std::begin(expected), std::end(expected), std::begin(lowered), std::end(lowered), [] (const auto& left, const auto& right) {
+			return left.code == right.code && left.slot == right.slot && left.operation.type == right.operation.type
+				&& (left.constant ? right.constant && left.constant->toString() == right.constant->toString() : !right.constant);
+		});
 }
 
-std::string evaluate(const std::string& expression) 
+//	parses the statement into a syntax tree and evaluates its program, formatting the result as evaluate() would
+std::string evaluateTree(const std::string& expression)
 {
-	std::shared_ptr<token::operand::Operand> result;
+	try {
+		const auto statement = compiled::Expression::compile(compiled::SyntaxTree::parse(expression));
+		return statement.evaluate(statement.bind(compiled::parseVariables(expression)))->toString();
+	}
+	catch (const std::exception& e) {
+		return "Error(s):\n\n" + std::string(e.what()) + "\n";
+	}
+}
 
+//	compiles and evaluates the expression within the limits, formatting the result as evaluate() would
+std::string evaluateWithin(const std::string& expression, const compiled::Limits& limits, compiled::CancellationToken token = {})
+{
 	try {
-		const std::vector<token::Variable> vars = parseVariables(expression);
-		result = parseStatement(expression, vars);
+		compiled::Budget budget(limits, token);
+		const auto statement = compiled::Expression::compile(expression, budget);
+		return statement.evaluate(statement.bind(compiled::parseVariables(expression)), budget)->toString();
 	}
 	catch (const std::exception& e) {
 		return "Error(s):\n\n" + std::string(e.what()) + "\n";
 	}
+}
 
-	return result->toString();
+#ifdef __linux__
+//	what 'client' makes of a peer that sends 'frame' once connected, and keeps the connection open until the client hangs up
+template <typename Client>
+std::string againstPeer(const std::string& frame, Client&& client)
+{
+	const std::string path = "vba-expression-frames.sock";
+
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	std::strcpy(address.sun_path, path.c_str());
+
+	const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(path.c_str());
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0)
+		return "Cannot listen";
+
+	std::thread peer([listener, &frame] {
+		const auto connection = accept(listener, nullptr, nullptr);
+		[[maybe_unused]] const auto sent = send(connection, frame.data(), frame.size(), MSG_NOSIGNAL);
+
+		char buffer[16];
+		while (recv(connection, buffer, sizeof(buffer), 0) > 0);
+		close(connection);
+	});
+
+	std::string outcome;
+	try {
+		outcome = client(path);
+	}
+	catch (const std::exception& e) {
+		outcome = e.what();
+	}
+
+	peer.join();
+	close(listener);
+	unlink(path.c_str());
+	return outcome;
 }
 
+//	what a client makes of a response frame of 'length' zero bytes
+std::string receiveFrame(std::uint32_t length)
+{
+	std::string frame;
+	utils::bytes::store32(frame, length);
+	frame.append(length, '\0');
+
+	return againstPeer(frame, [] (const std::string& path) { return "text '" + server::Client(path).receive().text + "'"; });
+}
+#endif
+
 void tests()
 {
 	//	Integers
@@ -225,14 +361,704 @@ void tests()
 	assert(evaluate("x1 = 5 x2 = 3 y1 = 1; (x1+x2*2)+y1*2+Sin(y1-1)") == "13");
 	assert(evaluate("x = 5 y=20 a = 24 ; Cos(a * y >> 2.3) ^ (x / Abs(Not 5))") == "0,842559907342032");
 
+	//	every value keeps its first digit, with or without a sign
+	const auto preamble = compiled::parseVariables("x = 12 y = -34 z = +5.5 w = 1.25@ v = - 7;");
+	assert(preamble.size() == 5 && preamble[0].operand->toString() == "12" && preamble[1].operand->toString() == "-34");
+	assert(preamble[2].operand->toString() == "5,5" && preamble[3].operand->toString() == "1,25" && preamble[4].operand->toString() == "-7");
+
 	//	Functions
 	assert(evaluate("Sin(30)") == "-0,988031624092862");
 	assert(evaluate("Sin(30) + Cos(0.25) - Abs(3.0 + True) + Acos(0.53) * Atan(0.93) + Ceiling(0.2) -"
 					"Floor(5.8) + Exp(2.2) + Round(16) + Log10(3 + 5 / 4) + Sqrt(4) - Truncate(23.98)") == "-0,607435759156953");
+
+	//	Scanning
+	assert(utils::str::countWhitespace(" \t\n\v\f\r x") == 7);
+	assert(utils::str::countWhitespace(std::string(100, ' ') + "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tx") == 132);
+	assert(utils::str::countDigits(std::string(40, '7') + "x") == 40);
+	assert(utils::str::countIdentifier(std::string(70, 'a') + "_9Z") == 72);
+	assert(utils::str::countIdentifier("\xE4") == 0);
+	assert(evaluate("abcdefghijklmnopqrstuvwxyz_0123456789 = 4;" + std::string(64, ' ') + "abcdefghijklmnopqrstuvwxyz_0123456789 *\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t 2.5") == "10");
+	assert(evaluate("2 * 0x1.8p1 + 1234567 - 1.5e3 + 2.E1") == "1233093");
+
+	//	Batch
+	assert(evaluateTable("m = 10; (x - m) * y", "x,y\n12,2\n7.5,True\n") == "result\n4\n2,5\n");
+	assert(evaluateTable("x * 2", "name\tx\r\na\t-3\r\n\r\nb\t+4") == "result\n-6\n8\n");
+
+	std::string table = "x,y\n", expected = "result\n";
+	for (auto row = 0; row < 500; ++row) {
+		const auto x = std::to_string(row), y = std::to_string(row % 7) + ".5";
+		table += x + "," + y + "\n";
+		expected += evaluate("x = " + x + " y = " + y + "; x Mod 13 + Sqrt(y) * x") + "\n";
+	}
+
+	batch::Options options;
+	options.threads = 4;
+	options.chunkSize = 64;
+	options.chunksInFlight = 2;
+	assert(evaluateTable("x Mod 13 + Sqrt(y) * x", table, options) == expected);
+
+	options.chunkSize = 1 << 20;
+	options.chunkCost = 2000;
+	assert(evaluateTable("x Mod 13 + Sqrt(y) * x", table, options) == expected);
+
+	auto rejected = false;
+	options.maxCost = compiled::estimateCost(compiled::Expression::compile("x Mod 13 + Sqrt(y) * x")) - 1;
+	try { evaluateTable("x Mod 13 + Sqrt(y) * x", table, options); }
+	catch (const std::runtime_error&) { rejected = true; }
+	assert(rejected && evaluateTable("x + y", table, options).size() > 500);
+	assert(compiled::estimateCost(compiled::Expression::compile("Exp(x) ^ Log(y) + Sin(x) * Cos(y)")) > 3 * compiled::estimateCost(compiled::Expression::compile("x + y")));
+
+	//	a superinstruction costs less than the instructions it stands for, and most for an operation it computes itself
+	const auto superinstructions = compiled::Expression::compile("x * 2 + Sqrt(y)").getSuperinstructions();
+	assert(superinstructions.size() == 2 && superinstructions[0].first == 0 && superinstructions[0].second == 3 && superinstructions[1].first == 3 && superinstructions[1].second == 2);
+	assert(compiled::Expression::compileBaseline("x * 2 + Sqrt(y)").getSuperinstructions().empty());
+	assert(compiled::estimateCost(compiled::Expression::compile("x * 2")) + 30 < compiled::estimateCost(compiled::Expression::compileBaseline("x * 2")));
+	assert(compiled::estimateCost(compiled::Expression::compile("Sqrt(y)")) < compiled::estimateCost(compiled::Expression::compileBaseline("Sqrt(y)")));
+
+	//	Serialization
+	const auto image = serialized::write({{"pricing", compiled::Expression::compile("x * 2.5 + True")},
+										  {"check", compiled::Expression::compile("(a + 1) > b OrElse False")},
+										  {"constant", compiled::Expression::compile("-Sqrt(16) \\ 3 + 0.25 - 2 ^ 3")}});
+	assert(serialized::Catalogue(image).size() == 3);
+	assert(!serialized::Catalogue(image).find("missing"));
+	assert(evaluateImage(image, "pricing", "x = 4;") == "9");
+	assert(evaluateImage(image, "check", "a = 2 b = 3;") == "False");
+	assert(evaluateImage(image, "constant", "") == evaluate("-Sqrt(16) \\ 3 + 0.25 - 2 ^ 3"));
+
+	auto corrupted = image;
+	corrupted.back() ^= 1;
+	assert(isRejected(corrupted));
+	assert(isRejected(image.substr(0, image.size() - 1)));
+	assert(isRejected("VBAE"));
+
+	//	IntegerPower from a version 1 image, which predates it
+	auto squared = serialized::write({{"square", compiled::Expression::compile("x ^ 2")}});
+	assert(evaluateImage(squared, "square", "x = 3;") == "9");
+	squared[4] = 1;
+	assert(isRejected(squared));
+
+	//	Specialization
+	const auto formula = compiled::Expression::compile("(x - m) / s + Log10(k * 2) * y - 2 ^ 3");
+	const auto residual = formula.specialize(formula.bind(compiled::parseVariables("m = 3 s = 2 k = 50;")));
+	assert(residual.getInstructions().size() == 11 && formula.getInstructions().size() == 16);
+	assert(residual.evaluate(residual.bind(compiled::parseVariables("x = 7 y = 1.5;")))->toString()
+		   == evaluate("m = 3 s = 2 k = 50 x = 7 y = 1.5; (x - m) / s + Log10(k * 2) * y - 2 ^ 3"));
+
+	compiled::Specializations tenants(formula);
+	const auto tenant = tenants.get("tenant", compiled::parseVariables("m = 1 s = 4 k = 5 y = True;"));
+	assert(tenants.get("tenant", {}) == tenant);
+	assert(tenant->getInstructions().size() == 9);
+	assert(tenant->evaluate(tenant->bind(compiled::parseVariables("x = 9;")))->toString()
+		   == evaluate("m = 1 s = 4 k = 5 y = True x = 9; (x - m) / s + Log10(k * 2) * y - 2 ^ 3"));
+
+	//	Registry
+	compiled::Registry registry;
+	{
+		compiled::Registry::Reader reader(registry);
+		assert(compiled::Registry::Snapshot(reader)->getNumber() == 0);
+		assert(compiled::Registry::Snapshot(reader)->find("pricing.v3") == nullptr);
+
+		assert(registry.publish({{"pricing.v3", "x * 2 + 1"}, {"discount", "x * 0.9"}}) == 1);
+		{
+			const compiled::Registry::Snapshot first(reader);
+			const auto pricing = first->find("pricing.v3");
+			assert(first->size() == 2 && first->find("discount") != nullptr && first->find("pricing") == nullptr);
+			assert(pricing->evaluate(pricing->bind(compiled::parseVariables("x = 10;")))->toString() == "21");
+
+			//	the snapshot keeps its version after a reload, which is only freed once the snapshot is gone
+			assert(registry.publish({{"pricing.v3", "x * 3"}}) == 2);
+			assert(pricing->evaluate(pricing->bind(compiled::parseVariables("x = 10;")))->toString() == "21");
+			assert(registry.reclaim() == 1);
+		}
+		assert(registry.reclaim() == 0);
+
+		const compiled::Registry::Snapshot second(reader);
+		assert(second->getNumber() == 2 && second->size() == 1 && second->find("discount") == nullptr);
+	}
+
+	try {
+		registry.publish({{"a", "1"}, {"b", "(2 + 3"}});
+		assert(false);
+	}
+	catch (const std::runtime_error& e) {
+		assert(std::string(e.what()) == "Formula 'b': Mismatched parentheses");
+	}
+
+	try {
+		registry.publish({{"a", "1"}, {"a", "2"}});
+		assert(false);
+	}
+	catch (const std::runtime_error& e) {
+		assert(std::string(e.what()) == "Formula 'a' registered twice");
+	}
+
+	{
+		//	readers evaluating while versions are published: every formula evaluates to the number of its version
+		std::atomic<bool> reloading(true);
+		std::atomic<std::size_t> inconsistent(0);
+		std::vector<std::thread> readers;
+
+		for (auto i = 0; i < 4; ++i)
+			readers.emplace_back([&registry, &reloading, &inconsistent] {
+				compiled::Registry::Reader reader(registry);
+				while (reloading.load())
+				{
+					const compiled::Registry::Snapshot snapshot(reader);
+					const auto formula = snapshot->find("version");
+					if (formula && formula->evaluate({})->toString() != std::to_string(snapshot->getNumber()))
+						++inconsistent;
+				}
+			});
+
+		for (auto version = std::uint64_t(3); version < 200; ++version)
+			assert(registry.publish({{"version", std::to_string(version)}}) == version);
+
+		reloading = false;
+		for (auto& reader : readers)
+			reader.join();
+
+		assert(inconsistent == 0);
+		assert(registry.reclaim() == 0);
+	}
+
+	//	Strength reduction
+	const auto reduced = compiled::Expression::compile("x ^ 2 + x ^ 2.0 / 8");
+	assert(reduced.getInstructions()[2].operation.type == token::Operator::IntegerPower);
+	assert(reduced.getInstructions()[7].operation.type == token::Operator::Multiplication);
+	assert(evaluate("x = 3; x ^ 2 + x ^ 2.0 / 8") == "10,125");
+	assert(evaluate("x = 1.1; x ^ 2") == "1,21");
+	assert(evaluate("x = 3; x ^ 40") == "1,21576654590569E+19");
+	assert(evaluate("x = -2; x ^ -1 + x ^ 0 + x ^ 3 / 0.25") == "-31,5");
+
+	//	a NaN base gives the bits std::pow gives, sign included, whether the exponent is constant or bound
+	assert(floatBits("Log(-2) ^ 2") == floatBits("y = 2; Log(-2) ^ y") && floatBits("Log(-2) ^ True") == floatBits("y = True; Log(-2) ^ y"));
+	assert(floatBits("Log(-2) ^ -1") == floatBits("y = -1; Log(-2) ^ y"));
+
+	//	Functions
+	assert(evaluate("f(a, b) = a * b + 1; f(2, 3)") == "7");
+	assert(evaluate("x = 4 sq(a) = a * a, y = 2; sq(x - y) + sq(3)") == evaluate("x = 4 y = 2; ((x - y) * (x - y)) + (3 * 3)"));
+	assert(evaluate("f(a) = a * 2, g(a, b) = f(a) - f(b) / 4; g(Sin(1), (2 + 3)) ^ 2") == evaluate("((Sin(1) * 2) - ((2 + 3) * 2) / 4) ^ 2"));
+	assert(evaluate("x = 10 f(a) = a + x; f(1)") == "11");
+	assert(evaluate("zero() = 42; zero() + 1") == "43");
+	assert(evaluate("f(a, b) = a + b; f(1)") == "Error(s):\n\nFunction 'f' takes 2 argument(s)\n");
+	assert(evaluate("f(a) = f(a) + 1; f(1)") == "Error(s):\n\nFunction 'f' calls itself\n");
+	assert(evaluate("f(a) = a; f(1") == "Error(s):\n\nMismatched parentheses\n");
+	std::string nested = "f0(a) = a + 1";
+	for (auto i = 1; i <= 20; ++i)
+		nested += ", f" + std::to_string(i) + "(a) = f" + std::to_string(i - 1) + "(a)";
+	assert(evaluate(nested + "; f10(1)") == "2");
+	assert(evaluate(nested + "; f20(1)") == "Error(s):\n\nFunctions nested more than 16 levels deep\n");
+
+	//	Filter
+	std::vector<long long> filterX, filterB, filterS;
+	std::vector<double> filterY;
+	for (auto row = 0; row < 200; ++row) {
+		filterX.push_back(row * 37 % 101 - 50);
+		filterY.push_back(row % 17 ? row * 0.5 - 30 : std::nan(""));
+		filterB.push_back(row % 3 ? 0 : -1);
+		filterS.push_back(row);
+	}
+
+	const std::vector<std::pair<std::string, compiled::Column>> filterTable {{"x", filterX}, {"y", filterY}, {"b", filterB}, {"s", filterS}};
+	for (const auto& predicate : {"x > 10", "lo = 5; lo <= x AndAlso y < 20.5", "x = y Or (y <> 3.5 And x >= -20)", "Not (x < 0 OrElse y = 1) And b",
+								  "x Mod 7 = 3 OrElse Sqrt(Abs(y)) > 4", "x And 6", "5 > x", "x < 2.5", "y >= x", "x = x", "False AndAlso x"})
+		assert(filterRows(predicate, filterTable, 200) == filterRows(predicate, filterTable, 200, true));
+	assert(filterRows("x <> 0 AndAlso 100 \\ x > 3", filterTable, 200) == filterRows("x <> 0 AndAlso 100 \\ (x + (x = 0)) > 3", filterTable, 200, true));
+	assert(filterRows("x > 45 AndAlso y > 0", filterTable, 200) == std::vector<std::size_t>({90, 120, 131, 150, 161, 191}));
+	assert(compiled::toSelection({0b1010, 1}) == std::vector<std::size_t>({1, 3, 64}));
+
+	//	Intervals
+	const compiled::Interval unit {0, 1, false, false}, small {-2, 3, false, true}, anyFloat {-INFINITY, INFINITY, true, false};
+	assert(boundOf("x * x - 1", {small}).lo == -7 && boundOf("x * x - 1", {small}).hi == 8);
+	assert(boundOf("x ^ 2", {small}).lo == 0 && boundOf("x ^ 2", {small}).hi > 9 && !boundOf("x ^ 2", {small}).nan);
+	assert(boundOf("x \\ 2 + x Mod 2", {small}).integer && boundOf("-x", {small}).lo == -3);
+	assert(boundOf("Sqrt(x - 1)", {unit}).nan && !boundOf("Sqrt(x + 1)", {unit}).nan);
+	assert(boundOf("x / (y - 0.5)", {unit, unit}).nan && !boundOf("x / (y + 0.5)", {unit, unit}).nan);
+	assert(boundOf("Sin(x)", {anyFloat}).nan && boundOf("Sin(x)", {small}).hi == 1);
+	assert(compiled::decide(compiled::Expression::compile("x > 5 AndAlso y < 2"), {small, unit}) == compiled::Truth::False);
+	assert(compiled::decide(compiled::Expression::compile("x > -5 And y < 2"), {small, unit}) == compiled::Truth::True);
+	assert(compiled::decide(compiled::Expression::compile("x > 0 OrElse y < 2"), {small, anyFloat}) == compiled::Truth::Unknown);
+	assert(compiled::decide(compiled::Expression::compile("y <> 3"), {small, anyFloat}) == compiled::Truth::Unknown);
+	assert(compiled::decide(compiled::Expression::compile("x <> 4"), {small}) == compiled::Truth::True);
+	for (const auto& predicate : {"x > 10", "x < 2.5 AndAlso y >= 0", "x + y > 40 OrElse b", "Not (y < 1) And x Mod 5 = 3", "Sqrt(Abs(y)) * 2 > x ^ 2",
+								  "s < 100 AndAlso x > 0", "s >= 64 And s < 128 Or y > 60", "Log(s) > 4", "s \\ 64 = 2 OrElse s * 2 < 20"})
+		assert(filterZones(predicate, filterTable, 200, 64) == filterRows(predicate, filterTable, 200, true));
+
+	//	Currency
+	assert(evaluate("0.1@ + 0.2@ = 0.3@") == "True" && evaluate("0.1@ + 0.2 = 0.3") == "False");
+	assert(evaluate("19.99@ * 3 - 0.01@") == "59,96");
+	assert(evaluate("1.0005@ * 0.5@ + 1.0015@ * 0.5@") == "1,001");
+	assert(evaluate("-12.34567@ + 2.00005@ - 2.00015@") == "-12,3459");
+	assert(evaluate("x = -0.0001@ n = 3; x * n * 10000 + True") == "-4");
+	assert(evaluate("100@ / 8 + 7.5@ Mod 2") == "14");
+	assert(evaluate("Round(2.5@) + Round(3.5@) + Floor(-1.0001@) + Ceiling(1.0001@) + Truncate(-0.9999@)") == "6");
+	assert(evaluate("922337203685477.5807@ > 922337203685477 AndAlso 9223372036854775807 > 0.0001@") == "True");
+	assert(evaluate("922337203685477.5807@ + 0.0001@") == "Error(s):\n\nOverflow\n");
+	assert(evaluate("307445734561826@ * 3") == "Error(s):\n\nOverflow\n" && evaluate("922337203685478@") == "Error(s):\n\nOverflow\n");
+	assert(evaluate("7.5@ Mod 0") == "Error(s):\n\nDivision by zero\n");
+	assert(evaluateCatalogue({"x * 5000", "x * 0.5@"}, "x = 3;") == std::vector<std::string>({"15000", "1,5"}));
+	assert(evaluateImage(serialized::write({{"price", compiled::Expression::compile("x * 1.15@ - 0.01@")}}), "price", "x = 20;") == "22,99");
+	for (const auto& predicate : {"x > 12.5@", "s * 0.25@ <= 20.5@ AndAlso y < 3@", "x + 0.0001@ > 0 OrElse y = 1.5@"})
+		assert(filterRows(predicate, filterTable, 200) == filterRows(predicate, filterTable, 200, true)
+			   && filterZones(predicate, filterTable, 200, 64) == filterRows(predicate, filterTable, 200, true));
+	assert(boundOf("x * 0.1@", {small}).currency && boundOf("x * 0.1@", {small}).lo <= -0.2 && boundOf("x * 0.1@", {small}).hi >= 0.3);
+
+	incremental::Session money("x = 3; x * 0.1@ = 0.3@");
+	assert(money.evaluate()->toString() == "True" && editSession(money, money.getText().find("@ ="), 1, "") == "False");
+
+	//	Memo
+	const std::vector<std::string> memoFormulas {"Sin(30)", "x = 0.1; Cos(x) + Tan(x) * Atan(x)", "Log(-1)", "Sqrt(-0.0)", "x = 2.5@; Exp(x) - Log10(x)",
+												 "Asin(0.5) + Acos(0.5) + Sin(30) * Sin(30.000000000000004)"};
+	std::vector<std::uint64_t> unmemoized;
+	for (const auto& formula : memoFormulas)
+		unmemoized.push_back(floatBits(formula));
+	token::memo::enable(true);
+	token::memo::clear();
+	for (auto pass = 0; pass < 2; ++pass)
+		for (auto i = 0u; i < memoFormulas.size(); ++i)
+			assert(floatBits(memoFormulas[i]) == unmemoized[i]);
+	assert(token::memo::statistics().hits > 0 && token::memo::statistics().hits + token::memo::statistics().misses == 24);
+	std::thread([] { assert(token::memo::statistics().hits == 0 && evaluate("Sin(30) > 0") == "False"); }).join();
+	token::memo::enable(false);
+	token::memo::clear();
+	assert(evaluate("Sin(30)") == evaluate("x = 30; Sin(x)") && token::memo::statistics().hits + token::memo::statistics().misses == 0);
+
+	//	Syntax trees
+	for (const auto& formula : {"(x - m) / s + Log10(y)", "-2 ^ 2 * -x", "2 ^ -3 * 4 + Not a = b And c Xor Not b Or d", "a * Not b + c <> 1",
+								"Sin x ^ 2 + Cos(x) ^ -Abs(y) \\ 3 Mod 2 << 1", "x ^ 2 / 8 - 1.5@ * True >= y OrElse z AndAlso Not False", "((((x))))"})
+		assert(compilesAlike(formula));
+	assert(evaluateTree("x = 3 y = 4; Sqrt(x * x + y * y) - -1") == "6" && evaluateTree("2 ^ 3 ^ 2") == evaluate("2 ^ 3 ^ 2"));
+	assert(evaluateTree("x z") == "Error(s):\n\nMissing operator\n" && evaluateTree("(x) (y)") == "Error(s):\n\nMissing operator\n");
+	assert(evaluateTree("(x - m) / s +") == "Error(s):\n\nMissing operand\n" && evaluateTree("x * / 2") == "Error(s):\n\nMissing operand\n");
+	assert(evaluateTree("(x + 1") == "Error(s):\n\nMismatched parentheses\n" && evaluateTree("x + 1)") == "Error(s):\n\nMismatched parentheses\n");
+	assert(evaluateTree("x = 1; ") == "Error(s):\n\nEmpty expression\n" && evaluateTree("x # 2") == "Error(s):\n\nUnexpected '#'\n");
+
+	const auto deep = std::string(100000, '(') + "x" + std::string(100000, ')') + " + " + std::string(50000, '-') + "1";
+	assert(compiled::SyntaxTree::parse(deep).getNodes().size() == 50003 && evaluateTree("x = 2; " + deep) == "3");
+
+	//	Superinstructions
+	assert(evaluate("x = 2 y = 3; x * 2.5 + y * y - Sqrt(x) / 4 * 0") == "14" && evaluate("x = 2 y = 3; x * y - 7 + y") == "2");
+	assert(evaluate("x = 2; x / 4 + (x = 2.0) - x * 0.1") == "-0,7" && evaluate("x = 3; x <= 3 And x > 2.5 AndAlso x <> 3.5") == "True");
+	assert(evaluate("x = True y = 5; x + 1 - (y >= x)") == "1" && evaluate("x = 1.5@ y = 0.1; x * 3 + x - y * 10") == "5");
+	assert(evaluate("x = 0.1@ y = 0.2@; x + y = 0.3@") == "True" && evaluate("x = 9223372036854775807; x - 1 > x") == "False");
+	assert(evaluate("y = 4; x * 2") == "Error(s):\n\nMissing operand\n" && evaluate("y = 4; Sqrt(x) * y") == "Error(s):\n\nMissing operand\n");
+	assert(floatBits("x = 0.1 y = 0.2; x + y * 3 / 7 - Sin(x)") == floatBits("0.1 + 0.2 * 3 / 7 - Sin(0.1)"));
+
+	//	Tiering
+	compiled::TieredExpression tiered("x ^ 2 + (2 * 4) / 8 - y", 3);
+	const auto tieredBindings = tiered.bind(compiled::parseVariables("x = 3 y = 0.5;"));
+	assert(tiered.getTier() == compiled::Tier::Baseline && tiered.getExpression().getInstructions()[2].operation.type == token::Operator::Power);
+
+	for (auto i = 0; i < 3; ++i)
+		assert(tiered.evaluate(tieredBindings)->toString() == "9,5");
+
+	tiered.waitForPromotion();
+	assert(tiered.getTier() == compiled::Tier::Optimized && tiered.evaluate(tieredBindings)->toString() == "9,5");
+	assert(tiered.getExpression().getInstructions().size() == 7 && tiered.getExpression().getInstructions()[2].operation.type == token::Operator::IntegerPower);
+	assert(tiered.statistics(compiled::Tier::Baseline).evaluations == 3 && tiered.statistics(compiled::Tier::Baseline).instructions == 11);
+	assert(tiered.statistics(compiled::Tier::Optimized).evaluations == 1 && tiered.statistics(compiled::Tier::Optimized).instructions == 7);
+
+	assert(compiled::TieredExpression("f(a) = a * 2; f(3) + 1", 0).getTier() == compiled::Tier::Optimized);
+	assert(compiled::TieredExpression("f(a) = a * 2; f(3) + 1", 0).getExpression().getInstructions().size() == 1);
+	assert(compiled::TieredExpression("x + 1").statistics(compiled::Tier::Optimized).instructions == 0);
+
+	//	an optimization that fails leaves the expression in the baseline tier, where it fails as it would have
+	compiled::TieredExpression unoptimizable("2 +", 0);
+	assert(unoptimizable.getTier() == compiled::Tier::Baseline);
+	try {
+		unoptimizable.evaluate({});
+		assert(false);
+	}
+	catch (const std::runtime_error& e) {
+		assert(std::string(e.what()) == "Missing operand");
+	}
+
+	for (const auto expression : {"x = 2 y = 3; x * 2.5 + y * y - Sqrt(x) / 4 * 0", "x = 1.5@ y = 0.1; x * 3 + x - y * 10", "x = 7; x ^ (1 + 1) / (2 ^ 2)", "x = 0.1 y = 0.2; x + y * 3 / 7 - Sin(x) > 0 Xor True"})
+	{
+		compiled::TieredExpression promoted(expression, 1);
+		const auto bindings = promoted.bind(compiled::parseVariables(expression));
+		assert(promoted.evaluate(bindings)->toString() == evaluate(expression));
+
+		promoted.waitForPromotion();
+		assert(promoted.getTier() == compiled::Tier::Optimized && promoted.evaluate(bindings)->toString() == evaluate(expression));
+	}
+
+	{
+		//	threads evaluating across the threshold while others wait for the promotion it starts
+		compiled::TieredExpression shared("x * 2 + 1", 50);
+		const auto sharedBindings = shared.bind(compiled::parseVariables("x = 4;"));
+		std::atomic<int> wrong(0);
+
+		std::vector<std::thread> users;
+		for (auto i = 0; i < 4; ++i)
+			users.emplace_back([&shared, &sharedBindings, &wrong, i] {
+				for (auto j = 0; j < 100; ++j) {
+					if (shared.evaluate(sharedBindings)->toString() != "9")
+						++wrong;
+					if (i % 2 == 0)
+						shared.waitForPromotion();
+				}
+			});
+		for (auto& user : users)
+			user.join();
+
+		shared.waitForPromotion();
+		assert(wrong == 0 && shared.getTier() == compiled::Tier::Optimized && shared.statistics(compiled::Tier::Baseline).evaluations >= 50);
+	}
+
+	//	Explain
+	const auto explained = compiled::Expression::compile("x = 2 y = 1.5; -x ^ 2 + y * Sqrt(w) > 0.5@");
+	const auto explainedBindings = explained.bind(compiled::parseVariables("x = 2 y = 1.5;"));
+	assert(compiled::explain(explained, explainedBindings) == "slots: x = 0 (Integer), y = 1 (Float), w = 2 (unbound)\n"
+															  "GreaterThan, precedence 10: unknown\n"
+															  "  Sum, precedence 7: unknown\n"
+															  "    Negative, precedence 3: Float\n"
+															  "      IntegerPower, precedence 2: Float\n"
+															  "        Variable x, slot 0: Integer\n"
+															  "        Constant 2: Integer\n"
+															  "    Multiplication, precedence 4: unknown\n"
+															  "      Variable y, slot 1: Float\n"
+															  "      Sqrt, precedence 1: unknown\n"
+															  "        Variable w, slot 2: unbound\n"
+															  "  Constant 0,5: Currency\n");
+	assert(compiled::explain(compiled::Expression::compile("x z + 1"), {}, compiled::PlanFormat::Json)
+		   == "{\"slots\":[{\"alias\":\"x\",\"slot\":0,\"type\":\"unbound\"},{\"alias\":\"z\",\"slot\":1,\"type\":\"unbound\"}],\"plan\":["
+			  "{\"node\":\"Variable\",\"alias\":\"x\",\"slot\":0,\"type\":\"unbound\"},{\"node\":\"Operation\",\"operator\":\"Sum\",\"precedence\":7,"
+			  "\"type\":\"unknown\",\"operands\":[{\"node\":\"Variable\",\"alias\":\"z\",\"slot\":1,\"type\":\"unbound\"},{\"node\":\"Constant\",\"value\":\"1\",\"type\":\"Integer\"}]}]}\n");
+
+	assert(compiled::explain(compiled::Expression::compile("Ceiling(x)"), {}) == "slots: x = 0 (unbound)\nCeil, precedence 1: unknown\n  Variable x, slot 0: unbound\n");
+
+	const auto analyzed = compiled::analyze(explained, explained.bind(compiled::parseVariables("x = 2 y = 1.5 w = 4;")), 5);
+	assert(analyzed.find("5 runs, evaluate: ") == 0 && analyzed.find("GreaterThan, precedence 10: Boolean [5 runs, ") != std::string::npos);
+	assert(analyzed.find("        Variable w, slot 2: Integer [5 runs]\n") != std::string::npos);
+	const auto failed = compiled::analyze(compiled::Expression::compile("x Mod 0@ + 1"), {std::make_shared<token::operand::Integer>(3)}, 3, compiled::PlanFormat::Json);
+	assert(failed.find("{\"runs\":3,") == 0 && failed.find(",\"error\":\"Division by zero\",\"slots\"") != std::string::npos);
+	assert(failed.find("\"operator\":\"Mod\",\"precedence\":6,\"type\":\"unknown\",\"runs\":3,") != std::string::npos
+		   && failed.find("\"operator\":\"Sum\",\"precedence\":7,\"type\":\"unknown\",\"runs\":0,") != std::string::npos);
+
+	//	Budgets
+	compiled::Limits limits;
+	std::string sum = "x = 1; x";
+	for (auto term = 0; term < 1000; ++term)
+		sum += " + x";
+
+	assert(evaluateWithin(sum, limits) == "1001" && evaluateWithin("((((1))))", limits) == "1");
+	limits.maxLength = sum.size() - 1;
+	assert(evaluateWithin(sum, limits) == "Error(s):\n\nExpression longer than " + std::to_string(sum.size() - 1) + " characters\n");
+	limits.maxDepth = 3;
+	assert(evaluateWithin("(((1)))", limits) == "1" && evaluateWithin("1 + ((((1))))", limits) == "Error(s):\n\nExpression nested more than 3 levels deep\n");
+	limits = {};
+	limits.maxOperations = 1000;
+	assert(evaluateWithin(sum, limits) == "1001" && evaluateWithin("x = 2; x * 3 + x", limits) == "8");
+	limits.maxOperations = 999;
+	assert(evaluateWithin(sum, limits) == "Error(s):\n\nEvaluation exceeded 999 operations\n");
+	limits.maxOperations = 2;
+	assert(evaluateWithin("x = 2; x * 3 + x", limits) == "8" && evaluateWithin("x = 2; x * 3 + x - 1", limits) == "Error(s):\n\nEvaluation exceeded 2 operations\n");
+	limits = {};
+	limits.timeout = std::chrono::nanoseconds(1);
+	assert(evaluateWithin(sum, limits) == "Error(s):\n\nDeadline exceeded\n" && evaluateWithin("1 + 2", limits) == "3");
+
+	compiled::CancellationToken cancellation;
+	std::thread([cancellation] { cancellation.cancel(); }).join();
+	assert(evaluateWithin(sum, {}, cancellation) == "Error(s):\n\nCancelled\n");
+
+	const auto longRunning = compiled::Expression::compile(sum);
+	const auto longBindings = longRunning.bind(compiled::parseVariables(sum));
+	compiled::CancellationToken stop;
+	compiled::Budget stoppable({}, stop);
+	std::thread canceller([stop] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); stop.cancel(); });
+	std::string stopped;
+	try { while (true) longRunning.evaluate(longBindings, stoppable); }
+	catch (const std::exception& e) { stopped = e.what(); }
+	canceller.join();
+	assert(stopped == "Cancelled");
+
+	//	Incremental editing
+	incremental::Session session("x = 2 y = 3; (x + 1) * (y - Sin(x) / 2) + 10");
+	assert(session.evaluate()->toString() == evaluate(session.getText()));
+	assert(editSession(session, session.getText().find("1)"), 1, "15") == evaluate("x = 2 y = 3; (x + 15) * (y - Sin(x) / 2) + 10"));
+	assert(editSession(session, session.getText().find("3;"), 1, "4.5") == evaluate("x = 2 y = 4.5; (x + 15) * (y - Sin(x) / 2) + 10"));
+	assert(editSession(session, session.getText().find(';') + 1, 0, "(") == "Error(s):\n\nMismatched parentheses\n");
+	assert(editSession(session, session.getText().find('('), 1, "") == evaluate("x = 2 y = 4.5; (x + 15) * (y - Sin(x) / 2) + 10"));
+	assert(editSession(session, session.getText().find('+', 20), 1, "And") == evaluate("x = 2 y = 4.5; (x + 15) * (y - Sin(x) / 2) And 10"));
+	assert(editSession(session, session.getText().find("And") + 3, 0, "Also") == evaluate("x = 2 y = 4.5; (x + 15) * (y - Sin(x) / 2) AndAlso 10"));
+	assert(editSession(session, session.getText().find(';'), 1, "") == evaluate("x = 2 y = 4.5 (x + 15) * (y - Sin(x) / 2) AndAlso 10"));
+
+	incremental::Session defined("f(a) = a * 2; f(3) + 1");
+	assert(editSession(defined, defined.getText().find('2'), 1, "5") == "16");
+	assert(editSession(defined, defined.getText().find("3)"), 1, "4") == "21");
+
+	//	Catalogue
+	const std::vector<std::string> catalogueFormulas {"(x - m) / s + Log10(y)", "((x - m) / s) ^ 2 - Log10(y)", "Log10(y) * z", "x z", "(x - m) / s +"};
+	const auto catalogueResults = evaluateCatalogue(catalogueFormulas, "x = 7 m = 3 s = 2 y = 1000;");
+	for (auto i = 0u; i < catalogueFormulas.size(); ++i)
+		assert(catalogueResults[i] == evaluate("x = 7 m = 3 s = 2 y = 1000; " + catalogueFormulas[i]));
+
+	compiled::Catalogue shared;
+	shared.add("first", "(x - m) / s + Log10(y)");
+	shared.add("second", "Log10(y) - (x - m) / s");
+	assert(shared.getNodes().size() == 9 && shared.getStatistics().instructions == 16);
+
+	//	Gradient
+	const auto differentiable = compiled::Expression::compile("x ^ 2 * y + Sin(y) - Sqrt(z) / x + Round(z) + 3");
+	const auto partials = compiled::gradient(differentiable, differentiable.bind(compiled::parseVariables("x = 2 y = 3 z = 4.0;")));
+	assert(partials.value->toString() == evaluate("x = 2 y = 3 z = 4.0; x ^ 2 * y + Sin(y) - Sqrt(z) / x + Round(z) + 3"));
+	assert(std::abs(partials.partials[*differentiable.slotOf("x")] - 12.5) < 1e-12);
+	assert(std::abs(partials.partials[*differentiable.slotOf("y")] - (4 + std::cos(3.0))) < 1e-12);
+	assert(std::abs(partials.partials[*differentiable.slotOf("z")] + 0.125) < 1e-12);
+	const auto stepwise = compiled::Expression::compile("x = 2.5; Round(x) + (x > 1) + x Mod 2");
+	assert(compiled::gradient(stepwise, stepwise.bind(compiled::parseVariables("x = 2.5;"))).partials[0] == 1);
+
+	//	C interface
+	assert(vbe_abi_version() == VBE_ABI_VERSION);
+	{
+		const auto context = vbe_context_create();
+		vbe_expression* priced = nullptr;
+
+		const std::string pricing = "discount = 0.25; price * quantity * (1 - discount) + fee";
+		assert(vbe_compile(context, pricing.data(), pricing.size(), &priced) == VBE_OK && vbe_expression_variables(priced) == 4);
+
+		auto aliasLength = std::size_t(0);
+		assert(std::string(vbe_expression_variable(priced, 1, &aliasLength)) == "quantity" && aliasLength == 8);
+
+		const double prices[] {19.99, 5, 0.5};
+		const std::int64_t quantities[] {3, 0, 8};
+		const std::int64_t fees[] {15000, 0, 0};
+		const vbe_column columns[] {
+			{"price", 5, VBE_FLOAT, prices},
+			{"quantity", 8, VBE_INTEGER, quantities},
+			{"unused", 6, VBE_INTEGER, quantities},
+			{"fee", 3, VBE_CURRENCY, fees}
+		};
+
+		vbe_value values[3];
+		assert(vbe_evaluate(context, priced, columns, 4, 3, values) == VBE_OK && std::string(vbe_context_error(context)).empty());
+		assert(values[0].type == VBE_FLOAT && values[0].value.real == std::get<double>(compiled::Expression::compile("19.99 * 3 * (1 - 0.25) + 1.5@")
+																								   .evaluate({})->getValue()));
+		assert(values[1].type == VBE_FLOAT && values[1].value.real == 0);
+
+		char text[64];
+		std::size_t offsets[4], length = 0;
+		assert(vbe_evaluate_text(context, priced, columns, 4, 3, text, sizeof(text), offsets, &length) == VBE_OK);
+		assert(std::string(text, offsets[1]) == evaluate("price = 19.99 quantity = 3 fee = 1.5@ " + pricing));
+		assert(std::string(text + offsets[2], offsets[3] - offsets[2]) == "3" && length == offsets[3]);
+
+		assert(vbe_evaluate_text(context, priced, columns, 4, 3, text, 4, offsets, &length) == VBE_BUFFER_TOO_SMALL && length == offsets[3]);
+
+		//	a failed row, a missing column and invalid arguments
+		vbe_expression* negated = nullptr;
+		const std::uint8_t flags[] {1, 0};
+		const vbe_column flagColumn {"x", 1, VBE_BOOLEAN, flags};
+		assert(vbe_compile(context, "x <> True", 9, &negated) == VBE_OK && vbe_evaluate(context, negated, &flagColumn, 1, 2, values) == VBE_OK);
+		assert(values[0].type == VBE_BOOLEAN && values[0].value.integer == 0 && values[1].value.integer == -1);
+
+		vbe_expression* overflowing = nullptr;
+		assert(vbe_compile(context, "fee * 900000000000000@", 22, &overflowing) == VBE_OK);
+		assert(vbe_evaluate(context, overflowing, columns, 4, 2, values) == VBE_ERROR && values[0].type == VBE_FAILED && values[1].type == VBE_CURRENCY);
+		assert(std::string(vbe_context_error(context)) == "Overflow");
+
+		//	a row whose result can't be formatted fails like any other, and the rows after it are still written
+		vbe_expression* exploding = nullptr;
+		const std::int64_t exponents[] {1000, 0};
+		const vbe_column exponentColumn {"x", 1, VBE_INTEGER, exponents};
+		assert(vbe_compile(context, "Exp(x)", 6, &exploding) == VBE_OK);
+		char messages[256];
+		length = 0;
+		assert(vbe_evaluate_text(context, exploding, &exponentColumn, 1, 2, messages, sizeof(messages), offsets, &length) == VBE_ERROR);
+		assert(std::string(messages, offsets[1]) == vbe_context_error(context) && std::string(messages + offsets[1], offsets[2] - offsets[1]) == "1"
+			   && length == offsets[2]);
+
+		assert(vbe_evaluate(context, priced, columns, 2, 3, values) == VBE_ERROR);
+		assert(std::string(vbe_context_error(context)) == "No column or value for variable 'fee'");
+		assert(vbe_evaluate(context, priced, nullptr, 4, 3, values) == VBE_INVALID_ARGUMENT);
+		assert(vbe_evaluate(nullptr, priced, columns, 4, 3, values) == VBE_INVALID_ARGUMENT);
+
+		vbe_expression* unbalanced = nullptr;
+		assert(vbe_compile(context, "(1 + 2", 6, &unbalanced) == VBE_ERROR && unbalanced == nullptr);
+		assert(std::string(vbe_context_error(context)) == "Mismatched parentheses");
+
+		//	one compiled expression evaluated from several threads, each with a context of its own
+		std::vector<std::thread> callers;
+		std::atomic<std::size_t> wrong(0);
+		for (auto i = 0; i < 4; ++i)
+			callers.emplace_back([priced, &columns, &wrong] {
+				const auto local = vbe_context_create();
+				vbe_value results[3];
+				for (auto round = 0; round < 100; ++round)
+					if (vbe_evaluate(local, priced, columns, 4, 3, results) != VBE_OK || results[2].value.real != 3)
+						++wrong;
+				vbe_context_destroy(local);
+			});
+		for (auto& caller : callers)
+			caller.join();
+		assert(wrong == 0);
+
+		vbe_expression_destroy(exploding);
+		vbe_expression_destroy(overflowing);
+		vbe_expression_destroy(negated);
+		vbe_expression_destroy(priced);
+		vbe_context_destroy(context);
+	}
+
+#ifdef __linux__
+	//	Server
+	server::Options serverOptions;
+	serverOptions.threads = 2;
+
+	server::Server service("vba-expression-tests.sock", serverOptions);
+	std::thread serving([&service] { service.run(); });
+
+	{
+		server::Client client("vba-expression-tests.sock");
+		assert(client.evaluate("x = 3 y=5; -x * y + 3").text == "-12");
+		assert(client.evaluate("x = 4 y=5; -x * y + 3").text == "-17");
+		assert(client.evaluate("(1 + 2").error);
+
+		client.send(1, "Sin(30)");
+		client.send(2, "2 ^ 8");
+		client.flush();
+		assert(client.receive().text == evaluate("Sin(30)"));
+		const auto second = client.receive();
+		assert(second.id == 2 && !second.error && second.text == "256");
+	}
+
+	{
+		//	a client pipelining far more responses than a connection may have pending, which it only reads afterwards
+		server::Options pausing;
+		pausing.threads = 1;
+		pausing.maxOutput = 64;
+
+		server::Server paused("vba-expression-paused.sock", pausing);
+		std::thread pausedServing([&paused] { paused.run(); });
+
+		server::Client client("vba-expression-paused.sock");
+		for (auto id = 0u; id < 2000; ++id)
+			client.send(id, "x = " + std::to_string(id) + "; x * 2");
+		client.flush();
+
+		auto inOrder = true;
+		for (auto id = 0u; id < 2000; ++id) {
+			const auto response = client.receive();
+			inOrder = inOrder && response.id == id && response.text == std::to_string(id * 2);
+		}
+		assert(inOrder);
+
+		paused.stop();
+		pausedServing.join();
+	}
+
+	{
+		//	more statements in turn than a worker keeps compiled, each evicting the one used least recently
+		server::Options caching;
+		caching.threads = 1;
+		caching.cacheSize = 2;
+
+		server::Server cached("vba-expression-cached.sock", caching);
+		std::thread cachedServing([&cached] { cached.run(); });
+
+		server::Client client("vba-expression-cached.sock");
+		auto right = true;
+		for (auto i = 0; i < 30; ++i)
+			right = right && client.evaluate("x = " + std::to_string(i) + "; x + " + std::to_string(i % 3)).text == std::to_string(i + i % 3);
+		assert(right && client.evaluate("x = 1; x + 1 +").error);
+
+		cached.stop();
+		cachedServing.join();
+	}
+
+	assert(receiveFrame(5) == "text ''" && receiveFrame(4) == "Corrupted response" && receiveFrame(0) == "Corrupted response");
+
+	const auto report = server::generateLoad("vba-expression-tests.sock", {"x = 2; x ^ 8", "Log10(1000)", "True And"}, 2, 300, 16);
+	assert(report.requests == 600 && report.errors == 200 && report.failedConnections == 0);
+
+	//	connections that fail are reported, not fatal: no server, and a peer answering a request never sent
+	const auto unserved = server::generateLoad("vba-expression-missing.sock", {"1"}, 2, 10, 1);
+	assert(unserved.requests == 0 && unserved.failedConnections == 2 && unserved.failure.find("vba-expression-missing.sock") != std::string::npos);
+
+	std::string unsent;
+	utils::bytes::store32(unsent, 5);
+	utils::bytes::store32(unsent, 1000);
+	unsent.push_back('\0');
+	assert(againstPeer(unsent, [] (const std::string& path) { return server::generateLoad(path, {"1"}, 1, 10, 1).failure; })
+		   == "Response to a request never sent (id 1000)");
+
+	service.stop();
+	serving.join();
+#endif
+}
+
+namespace
+{
+	server::Server* runningServer = nullptr;
+
+	void stopServer(int)
+	{
+		if (runningServer)
+			runningServer->stop();
+	}
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-	tests();
+	const std::vector<std::string> args(argv + 1, argv + argc);
+
+	try {
+		//	--bench [filter]: runs the microbenchmarks
+		if (!args.empty() && args[0] == "--bench")
+			benchmark::run(std::cout, args.size() > 1 ? args[1] : std::string());
+		//	--explain <expression> [runs] [--json]: prints how the expression was parsed, and where the time goes over that many runs
+		else if (args.size() >= 2 && args[0] == "--explain") {
+			const auto format = args.back() == "--json" ? compiled::PlanFormat::Json : compiled::PlanFormat::Text;
+			const auto statement = compiled::Expression::compile(args[1]);
+			const auto bindings = statement.bind(compiled::parseVariables(args[1]));
+
+			if (args.size() > 2 && args[2] != "--json")
+				std::cout << compiled::analyze(statement, bindings, std::stoul(args[2]), format);
+			else
+				std::cout << compiled::explain(statement, bindings, format);
+		}
+		//	--serve <socket> [threads]: answers evaluation requests on a Unix domain socket until interrupted
+		else if (args.size() >= 2 && args[0] == "--serve") {
+			server::Options options;
+			if (args.size() > 2)
+				options.threads = static_cast<unsigned>(std::stoul(args[2]));
+
+			server::Server service(args[1], options);
+			runningServer = &service;
+			std::signal(SIGINT, stopServer);
+			std::signal(SIGTERM, stopServer);
+
+			service.run();
+			runningServer = nullptr;
+		}
+		//	--load <socket> <expression> [connections] [requests per connection] [pipeline depth]
+		else if (args.size() >= 3 && args[0] == "--load") {
+			const auto connections = args.size() > 3 ? static_cast<unsigned>(std::stoul(args[3])) : 4u;
+			const auto requests = args.size() > 4 ? std::stoul(args[4]) : 100000ul;
+			const auto depth = args.size() > 5 ? std::stoul(args[5]) : 32ul;
+
+			const auto report = server::generateLoad(args[1], {args[2]}, connections, requests, depth);
+			std::cout << report.requests << " requests (" << report.errors << " errors) in " << report.seconds << " s: "
+					  << report.throughput << " req/s, p50 " << report.p50 << " us, p99 " << report.p99 << " us, p999 " << report.p999 << " us\n";
+			if (report.failedConnections > 0)
+				std::cout << report.failedConnections << " connection(s) failed, the first with: " << report.failure << "\n";
+		}
+		//	<formula> <table> [output]: evaluates the formula once per row of a CSV/TSV file
+		else if (args.size() >= 2) {
+			if (args.size() > 2) {
+				std::ofstream output(args[2], std::ios::binary);
+				batch::evaluateFile(args[0], args[1], output);
+			}
+			else
+				batch::evaluateFile(args[0], args[1], std::cout);
+		}
+		else
+			tests();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error(s):\n\n" << e.what() << "\n";
+		return 1;
+	}
+
 	return 0;
 }